@@ -0,0 +1,156 @@
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+#include "MigratoryDataAsyncClient.h"
+
+#include "config.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace migratorydata;
+
+// Bounds the number of publications in flight.
+class InFlight
+{
+
+private:
+	mutex lock;
+	condition_variable released;
+	int available;
+
+public:
+	InFlight(int limit) : available(limit)
+	{
+	}
+
+	void acquire()
+	{
+		unique_lock<mutex> guard(lock);
+		released.wait(guard, [this] { return available > 0; });
+		available--;
+	}
+
+	void release()
+	{
+		lock_guard<mutex> guard(lock);
+		available++;
+		released.notify_one();
+	}
+};
+
+// The callback path: each publish notification is matched by the application itself.
+class CallbackListener : public MigratoryDataListener
+{
+
+private:
+	MigratoryDataClient& client;
+
+public:
+	InFlight* inFlight = nullptr;
+
+	CallbackListener(MigratoryDataClient& client) : client(client)
+	{
+	}
+
+	void onMessage(const MigratoryDataMessage& message)
+	{
+	}
+
+	void onStatus(const string& status, string& info)
+	{
+		if (inFlight != nullptr && (status == client.NOTIFY_PUBLISH_OK || status == client.NOTIFY_PUBLISH_FAILED))
+		{
+			inFlight->release();
+		}
+	}
+};
+
+// Measure the cost of publishing through MigratoryDataAsyncClient, with completion callbacks and with futures,
+// against handling the publish notifications directly in the listener, with the same number of messages in flight.
+int main(int argc, char* argv[])
+{
+	string server = argc > 1 ? argv[1] : SERVER;
+	int messages = argc > 2 ? atoi(argv[2]) : 100000;
+	int concurrency = argc > 3 ? atoi(argv[3]) : 100;
+
+	MigratoryDataClient client;
+	CallbackListener listener(client);
+	MigratoryDataAsyncClient async(client, &listener);
+	client.setListener(&async);
+	string token = TOKEN;
+	client.setEntitlementToken(token);
+#if !defined (SSL_DISABLED)
+	client.setEncryption(ENCRYPTION);
+#endif
+	vector<string> servers;
+	servers.push_back(server);
+	client.setServers(servers);
+	if (async.connectAsync().get() != client.NOTIFY_SERVER_UP)
+	{
+		cerr << "cannot connect to " << server << endl;
+		return 1;
+	}
+
+	cout << "{" << endl
+		<< "  \"messages\": " << messages << "," << endl
+		<< "  \"concurrency\": " << concurrency << "," << endl;
+
+	const char* modes[] = { "callback", "asyncCallback", "future" };
+	for (int mode = 0; mode < 3; mode++)
+	{
+		InFlight inFlight(concurrency);
+		listener.inFlight = mode == 0 ? &inFlight : nullptr;
+		vector<future<string>> futures;
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int i = 0; i < messages; i++)
+		{
+			MigratoryDataMessage message("/async/benchmark", "x", mode == 0 ? to_string(i) : "");
+			if (mode == 0)
+			{
+				inFlight.acquire();
+				client.publish(message);
+			}
+			else if (mode == 1)
+			{
+				inFlight.acquire();
+				async.publishAsync(message, [&inFlight](const string& status) { inFlight.release(); });
+			}
+			else
+			{
+				futures.push_back(async.publishAsync(message));
+				if (static_cast<int>(futures.size()) == concurrency)
+				{
+					for (auto& f : futures)
+					{
+						f.get();
+					}
+					futures.clear();
+				}
+			}
+		}
+		for (int i = 0; mode < 2 && i < concurrency; i++)
+		{
+			inFlight.acquire();
+		}
+		for (auto& f : futures)
+		{
+			f.get();
+		}
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		cout << "  \"" << modes[mode] << "\": {\"seconds\": " << seconds << ", \"rate\": " << messages / seconds << "}"
+			<< (mode < 2 ? "," : "") << endl;
+	}
+	cout << "}" << endl;
+
+	client.disconnect();
+	return 0;
+}
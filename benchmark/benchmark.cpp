@@ -0,0 +1,502 @@
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+#include "MigratoryDataLogListener.h"
+#include "MigratoryDataAsyncLogListener.h"
+#include "MigratoryDataDispatchListener.h"
+#include "MigratoryDataPollListener.h"
+#include "MigratoryDataEventLoopListener.h"
+#include "MigratoryDataHistogram.h"
+#include "MigratoryDataPublishWindow.h"
+#include "MigratoryDataCompressionPolicy.h"
+#include "MigratoryDataShardedClient.h"
+#include "MigratoryDataTypedListener.h"
+
+#include "config.h"
+
+#if !defined (_WIN32)
+#include <poll.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace migratorydata;
+
+// Publishers and subscribers run in the same process, so the steady clock is shared and the latency
+// of a message is the difference between its reception time and the send time embedded in its content.
+static uint64_t nowNanos()
+{
+	return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+struct Config
+{
+	string server = SERVER;
+	string token = TOKEN;
+	bool encryption = ENCRYPTION;
+	string transport = "websocket";
+	int publishers = 1;
+	int subscribers = 1;
+	int connections = 1;
+	int subjects = 1;
+	int payload = 128;
+	int rate = 1000;
+	int duration = 30;
+	int warmup = 5;
+	string qos = "standard";
+	bool compressed = false;
+	int compressThreshold = 0;
+	string delivery = "callback";
+	int dispatchThreads = 4;
+	int window = 0;
+	string log = "none";
+	string logFile = "benchmark.log";
+	bool asyncLog = false;
+};
+
+static void usage()
+{
+	cerr << "usage: benchmark [options]" << endl
+		<< "  --server <host:port>        MigratoryData server (default " << SERVER << ")" << endl
+		<< "  --token <token>             entitlement token" << endl
+		<< "  --encryption                use SSL/TLS" << endl
+		<< "  --transport <websocket|http>" << endl
+		<< "  --publishers <n>            publishing clients (default 1)" << endl
+		<< "  --subscribers <n>           subscribing clients (default 1)" << endl
+		<< "  --connections <n>           connections per subscribing client, sharding the subjects (default 1)" << endl
+		<< "  --subjects <n>              subjects /benchmark/0 .. /benchmark/n-1 (default 1)" << endl
+		<< "  --payload <bytes>           content size (default 128)" << endl
+		<< "  --rate <msgs/sec>           per publisher, 0 for unlimited (default 1000)" << endl
+		<< "  --duration <seconds>        measured period (default 30)" << endl
+		<< "  --warmup <seconds>          unmeasured period before it (default 5)" << endl
+		<< "  --qos <standard|guaranteed>" << endl
+		<< "  --compressed                publish ZLIB-compressed content" << endl
+		<< "  --compress-threshold <n>    with --compressed, compress only contents of at least n bytes (default 0)" << endl
+		<< "  --delivery <callback|dispatch|poll|loop>" << endl
+		<< "  --dispatch-threads <n>      workers for --delivery dispatch (default 4)" << endl
+		<< "  --window <n>                max publishes in flight per publisher, 0 for unbounded (default 0)" << endl
+		<< "  --log <none|error|info|debug|trace>" << endl
+		<< "  --log-file <path>           destination of the logs (default benchmark.log)" << endl
+		<< "  --async-log                 write the logs from a background thread" << endl;
+}
+
+static bool parse(int argc, char* argv[], Config& config)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "--encryption") config.encryption = true;
+		else if (arg == "--compressed") config.compressed = true;
+		else if (arg == "--async-log") config.asyncLog = true;
+		else if (!hasValue) return false;
+		else if (arg == "--server") config.server = argv[++i];
+		else if (arg == "--token") config.token = argv[++i];
+		else if (arg == "--transport") config.transport = argv[++i];
+		else if (arg == "--publishers") config.publishers = atoi(argv[++i]);
+		else if (arg == "--subscribers") config.subscribers = atoi(argv[++i]);
+		else if (arg == "--connections") config.connections = atoi(argv[++i]);
+		else if (arg == "--subjects") config.subjects = atoi(argv[++i]);
+		else if (arg == "--payload") config.payload = atoi(argv[++i]);
+		else if (arg == "--rate") config.rate = atoi(argv[++i]);
+		else if (arg == "--duration") config.duration = atoi(argv[++i]);
+		else if (arg == "--warmup") config.warmup = atoi(argv[++i]);
+		else if (arg == "--qos") config.qos = argv[++i];
+		else if (arg == "--delivery") config.delivery = argv[++i];
+		else if (arg == "--dispatch-threads") config.dispatchThreads = atoi(argv[++i]);
+		else if (arg == "--window") config.window = atoi(argv[++i]);
+		else if (arg == "--compress-threshold") config.compressThreshold = atoi(argv[++i]);
+		else if (arg == "--log") config.log = argv[++i];
+		else if (arg == "--log-file") config.logFile = argv[++i];
+		else return false;
+	}
+	return config.publishers >= 0 && config.subscribers >= 0 && config.subjects > 0 && config.duration > 0 && config.window >= 0
+		&& config.connections > 0 && config.compressThreshold >= 0
+		&& (config.transport == "websocket" || config.transport == "http")
+		&& (config.qos == "standard" || config.qos == "guaranteed")
+		&& (config.delivery == "callback" || config.delivery == "dispatch" || config.delivery == "poll"
+#if !defined (_WIN32)
+			|| config.delivery == "loop"
+#endif
+			)
+		&& (config.log == "none" || config.log == "error" || config.log == "info" || config.log == "debug" || config.log == "trace");
+}
+
+static MigratoryDataLogLevel logLevelOf(const string& name)
+{
+	return name == "trace" ? LOG_TRACE : name == "debug" ? LOG_DEBUG : name == "info" ? LOG_INFO : LOG_ERROR;
+}
+
+class FileLogListener : public MigratoryDataLogListener
+{
+
+private:
+	mutex lock;
+	ofstream out;
+
+public:
+	FileLogListener(const string& path) : out(path.c_str())
+	{
+	}
+
+	void onLog(string& log, MigratoryDataLogLevel logLevel)
+	{
+		lock_guard<mutex> guard(lock);
+		out << logLevel << " " << log << '\n';
+	}
+};
+
+static atomic<bool> measuring(false);
+static atomic<bool> running(true);
+// the drainers of the poll and loop delivery modes keep going until every client is disconnected, since the
+// client threads may be blocked on a full queue meanwhile
+static atomic<bool> draining(true);
+
+class LatencyListener : public MigratoryDataTypedListener
+{
+
+private:
+	MigratoryDataHistogram& latency;
+	MigratoryDataHistogram& ackLatency;
+	atomic<uint64_t>& received;
+	atomic<uint64_t>& failed;
+
+public:
+	LatencyListener(MigratoryDataClient& client, MigratoryDataHistogram& latency, MigratoryDataHistogram& ackLatency,
+		atomic<uint64_t>& received, atomic<uint64_t>& failed)
+		: MigratoryDataTypedListener(client), latency(latency), ackLatency(ackLatency), received(received), failed(failed)
+	{
+	}
+
+	void onMessage(const MigratoryDataMessage& message)
+	{
+		uint64_t now = nowNanos();
+		if (!measuring.load(memory_order_relaxed) || message.getMessageType() != MessageType::UPDATE)
+		{
+			return;
+		}
+		uint64_t sent = strtoull(message.getContent().c_str(), nullptr, 10);
+		if (sent > 0 && sent <= now)
+		{
+			latency.record((now - sent) / 1000);
+			received.fetch_add(1, memory_order_relaxed);
+		}
+	}
+
+	void onStatusCode(const MigratoryDataStatus& status)
+	{
+		switch (status.getCode())
+		{
+		case StatusCode::PUBLISH_OK:
+			{
+				uint64_t sent = strtoull(status.getClosure().c_str(), nullptr, 10);
+				uint64_t now = nowNanos();
+				if (measuring.load(memory_order_relaxed) && sent > 0 && sent <= now)
+				{
+					ackLatency.record((now - sent) / 1000);
+				}
+			}
+			break;
+		case StatusCode::PUBLISH_FAILED:
+		case StatusCode::PUBLISH_DENIED:
+		case StatusCode::MESSAGE_SIZE_LIMIT_EXCEEDED:
+			failed.fetch_add(1, memory_order_relaxed);
+			break;
+		case StatusCode::SUBSCRIBE_ALLOW:
+		case StatusCode::SERVER_UP:
+			break;
+		default:
+			cerr << "status: " << status.getStatus() << " " << status.getInfo() << endl;
+			break;
+		}
+	}
+};
+
+// One client, made of --connections connections for a subscriber, together with the listener chain selected by --delivery.
+struct Endpoint
+{
+	unique_ptr<MigratoryDataShardedClient> client;
+	unique_ptr<LatencyListener> listener;
+	unique_ptr<MigratoryDataDispatchListener> dispatcher;
+	unique_ptr<MigratoryDataPollListener> poller;
+#if !defined (_WIN32)
+	unique_ptr<MigratoryDataEventLoopListener> eventLoop;
+#endif
+	unique_ptr<MigratoryDataPublishWindow> window;
+	thread drainer;
+};
+
+static void configure(Endpoint& endpoint, const Config& config, bool publisher, MigratoryDataLogListener* logListener,
+	MigratoryDataHistogram& latency, MigratoryDataHistogram& ackLatency, atomic<uint64_t>& received, atomic<uint64_t>& failed)
+{
+	endpoint.client.reset(new MigratoryDataShardedClient(publisher ? 1 : config.connections));
+	MigratoryDataShardedClient& client = *endpoint.client;
+	MigratoryDataClient& first = client.getClient(0);
+
+	if (logListener != nullptr)
+	{
+		client.setLogListener(logListener, logLevelOf(config.log));
+	}
+
+	endpoint.listener.reset(new LatencyListener(first, latency, ackLatency, received, failed));
+	MigratoryDataListener* listener = endpoint.listener.get();
+	if (config.delivery == "dispatch")
+	{
+		endpoint.dispatcher.reset(new MigratoryDataDispatchListener(endpoint.listener.get(), config.dispatchThreads, 65536, DispatchPolicy::BLOCK));
+		listener = endpoint.dispatcher.get();
+	}
+	else if (config.delivery == "poll")
+	{
+		endpoint.poller.reset(new MigratoryDataPollListener(65536, 1024, DispatchPolicy::BLOCK));
+		listener = endpoint.poller.get();
+		MigratoryDataPollListener* poller = endpoint.poller.get();
+		MigratoryDataListener* latencyListener = endpoint.listener.get();
+		endpoint.drainer = thread([poller, latencyListener] {
+			vector<MigratoryDataMessage> messages;
+			messages.reserve(256);
+			vector<pair<string, string>> statuses;
+			while (draining.load(memory_order_relaxed))
+			{
+				messages.clear();
+				statuses.clear();
+				poller->poll(messages, 256);
+				poller->pollStatus(statuses, 256);
+				if (messages.empty() && statuses.empty())
+				{
+					this_thread::yield();
+				}
+				for (auto& message : messages)
+				{
+					latencyListener->onMessage(message);
+				}
+				for (auto& status : statuses)
+				{
+					latencyListener->onStatus(status.first, status.second);
+				}
+			}
+		});
+	}
+#if !defined (_WIN32)
+	else if (config.delivery == "loop")
+	{
+		endpoint.eventLoop.reset(new MigratoryDataEventLoopListener(endpoint.listener.get(), 65536, DispatchPolicy::BLOCK));
+		listener = endpoint.eventLoop.get();
+		MigratoryDataEventLoopListener* eventLoop = endpoint.eventLoop.get();
+		endpoint.drainer = thread([eventLoop] {
+			// a minimal single-threaded reactor, woken up by the descriptor of the listener
+			pollfd descriptor = { eventLoop->getFileDescriptor(), POLLIN, 0 };
+			while (draining.load(memory_order_relaxed))
+			{
+				if (poll(&descriptor, 1, 100) > 0)
+				{
+					eventLoop->processEvents(256);
+				}
+			}
+		});
+	}
+#endif
+	if (publisher && config.window > 0)
+	{
+		endpoint.window.reset(new MigratoryDataPublishWindow(first, listener, config.window, WindowPolicy::BLOCK, chrono::milliseconds(60000)));
+		listener = endpoint.window.get();
+	}
+	client.setListener(listener);
+
+	string token = config.token;
+	client.setEntitlementToken(token);
+#if !defined (SSL_DISABLED)
+	client.setEncryption(config.encryption);
+#endif
+	client.setTransport(config.transport == "http" ? first.TRANSPORT_HTTP : first.TRANSPORT_WEBSOCKET);
+
+	vector<string> servers;
+	servers.push_back(config.server);
+	client.setServers(servers);
+}
+
+static string subjectOf(int index)
+{
+	ostringstream subject;
+	subject << "/benchmark/" << index;
+	return subject.str();
+}
+
+static void publishLoop(Endpoint& endpoint, const Config& config, int publisher, atomic<uint64_t>& published)
+{
+	QoS qos = config.qos == "guaranteed" ? QoS::GUARANTEED : QoS::STANDARD;
+	string padding(config.payload > 20 ? config.payload - 20 : 0, 'x');
+	chrono::steady_clock::time_point next = chrono::steady_clock::now();
+	chrono::nanoseconds interval(config.rate > 0 ? 1000000000LL / config.rate : 0);
+	MigratoryDataCompressionPolicy compression(static_cast<size_t>(config.compressThreshold));
+
+	for (uint64_t i = 0; running.load(memory_order_relaxed); i++)
+	{
+		string sent = to_string(nowNanos());
+		string content = sent;
+		content.append(1, ' ');
+		content.append(padding);
+
+		MigratoryDataMessage message(subjectOf(static_cast<int>((i * config.publishers + publisher) % config.subjects)), content, sent, qos, false, "");
+		if (config.compressed)
+		{
+			compression.apply(message);
+		}
+		if (endpoint.window)
+		{
+			endpoint.window->publish(message);
+		}
+		else
+		{
+			endpoint.client->publish(message);
+		}
+		if (measuring.load(memory_order_relaxed))
+		{
+			published.fetch_add(1, memory_order_relaxed);
+		}
+
+		if (config.rate > 0)
+		{
+			next += interval;
+			this_thread::sleep_until(next);
+		}
+	}
+}
+
+static void printPercentiles(const char* name, const MigratoryDataHistogram& histogram)
+{
+	cout << "  \"" << name << "\": {"
+		<< "\"count\": " << histogram.getCount()
+		<< ", \"min\": " << histogram.getMin()
+		<< ", \"mean\": " << histogram.getMean()
+		<< ", \"p50\": " << histogram.getValueAtPercentile(50)
+		<< ", \"p90\": " << histogram.getValueAtPercentile(90)
+		<< ", \"p99\": " << histogram.getValueAtPercentile(99)
+		<< ", \"p999\": " << histogram.getValueAtPercentile(99.9)
+		<< ", \"max\": " << histogram.getMax() << "}";
+}
+
+int main(int argc, char* argv[])
+{
+	Config config;
+	if (!parse(argc, argv, config))
+	{
+		usage();
+		return 1;
+	}
+
+	unique_ptr<FileLogListener> fileLogListener;
+	unique_ptr<MigratoryDataAsyncLogListener> asyncLogListener;
+	MigratoryDataLogListener* logListener = nullptr;
+	if (config.log != "none")
+	{
+		fileLogListener.reset(new FileLogListener(config.logFile));
+		logListener = fileLogListener.get();
+		if (config.asyncLog)
+		{
+			asyncLogListener.reset(new MigratoryDataAsyncLogListener(logListener, logLevelOf(config.log), 65536, chrono::milliseconds(10)));
+			logListener = asyncLogListener.get();
+		}
+	}
+
+	MigratoryDataHistogram latency;
+	MigratoryDataHistogram ackLatency;
+	atomic<uint64_t> received(0);
+	atomic<uint64_t> published(0);
+	atomic<uint64_t> failed(0);
+
+	vector<string> subjects;
+	for (int i = 0; i < config.subjects; i++)
+	{
+		subjects.push_back(subjectOf(i));
+	}
+
+	vector<unique_ptr<Endpoint>> subscribers;
+	for (int i = 0; i < config.subscribers; i++)
+	{
+		subscribers.emplace_back(new Endpoint());
+		configure(*subscribers.back(), config, false, logListener, latency, ackLatency, received, failed);
+		subscribers.back()->client->subscribe(subjects);
+		subscribers.back()->client->connect();
+	}
+
+	vector<unique_ptr<Endpoint>> publishers;
+	vector<thread> publishThreads;
+	for (int i = 0; i < config.publishers; i++)
+	{
+		publishers.emplace_back(new Endpoint());
+		configure(*publishers.back(), config, true, logListener, latency, ackLatency, received, failed);
+		publishers.back()->client->connect();
+	}
+	for (int i = 0; i < config.publishers; i++)
+	{
+		Endpoint* endpoint = publishers[i].get();
+		publishThreads.emplace_back([endpoint, &config, i, &published] { publishLoop(*endpoint, config, i, published); });
+	}
+
+	this_thread::sleep_for(chrono::seconds(config.warmup));
+	measuring.store(true);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	this_thread::sleep_for(chrono::seconds(config.duration));
+	measuring.store(false);
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	running.store(false);
+	for (auto& t : publishThreads)
+	{
+		t.join();
+	}
+	for (auto* endpoints : { &publishers, &subscribers })
+	{
+		for (auto& endpoint : *endpoints)
+		{
+			endpoint->client->disconnect();
+		}
+	}
+	draining.store(false);
+	for (auto* endpoints : { &publishers, &subscribers })
+	{
+		for (auto& endpoint : *endpoints)
+		{
+			if (endpoint->drainer.joinable())
+			{
+				endpoint->drainer.join();
+			}
+		}
+	}
+
+	cout << "{" << endl
+		<< "  \"config\": {\"server\": \"" << config.server << "\", \"transport\": \"" << config.transport
+		<< "\", \"publishers\": " << config.publishers << ", \"subscribers\": " << config.subscribers
+		<< ", \"connections\": " << config.connections
+		<< ", \"subjects\": " << config.subjects << ", \"payload\": " << config.payload
+		<< ", \"rate\": " << config.rate << ", \"duration\": " << config.duration
+		<< ", \"qos\": \"" << config.qos << "\", \"compressed\": " << (config.compressed ? "true" : "false")
+		<< ", \"compressThreshold\": " << config.compressThreshold
+		<< ", \"delivery\": \"" << config.delivery << "\", \"dispatchThreads\": " << config.dispatchThreads
+		<< ", \"window\": " << config.window
+		<< ", \"log\": \"" << config.log << "\", \"asyncLog\": " << (config.asyncLog ? "true" : "false") << "}," << endl
+		<< "  \"elapsedSeconds\": " << elapsed << "," << endl
+		<< "  \"published\": " << published.load() << "," << endl
+		<< "  \"publishFailed\": " << failed.load() << "," << endl
+		<< "  \"received\": " << received.load() << "," << endl
+		<< "  \"publishRate\": " << published.load() / elapsed << "," << endl
+		<< "  \"receiveRate\": " << received.load() / elapsed << "," << endl
+		<< "  \"droppedLogs\": " << (asyncLogListener ? asyncLogListener->getDroppedLogs() : 0) << "," << endl;
+	printPercentiles("latencyMicros", latency);
+	cout << "," << endl;
+	printPercentiles("publishAckLatencyMicros", ackLatency);
+	cout << endl << "}" << endl;
+
+	return 0;
+}
@@ -0,0 +1,144 @@
+#include "MigratoryDataZlibDictionaryCodec.h"
+
+#include <zlib.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace migratorydata;
+
+// JSON ticks shaped like market data, used when no captured contents are given.
+static vector<string> synthesize(size_t count)
+{
+	const char* symbols[] = { "AAPL", "MSFT", "GOOG", "AMZN", "META", "NVDA", "TSLA", "ORCL" };
+	mt19937 random(42);
+	auto next = [&random](unsigned bound) { return static_cast<unsigned>(random() % bound); };
+	vector<string> samples;
+	char buffer[256];
+	for (size_t i = 0; i < count; i++)
+	{
+		snprintf(buffer, sizeof(buffer),
+			"{\"symbol\":\"%s\",\"bid\":%u.%02u,\"ask\":%u.%02u,\"bidSize\":%u,\"askSize\":%u,\"time\":%llu}",
+			symbols[next(8)], 100 + next(400), next(100), 100 + next(400), next(100), next(10000), next(10000),
+			1700000000000ULL + i * 7);
+		samples.push_back(buffer);
+	}
+	return samples;
+}
+
+static double nanosSince(chrono::steady_clock::time_point start, size_t count)
+{
+	return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / count;
+}
+
+// Compare, on captured contents (one per line), the size and speed of deflating each content on its own, as
+// MigratoryDataMessage::setCompressed() does, and with a dictionary trained on the first half of the contents.
+// The dictionary can be saved to be loaded by the applications using MigratoryDataZlibDictionaryCodec.
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cerr << "usage: codec-benchmark <samples file, or - for synthetic JSON ticks> [dictionary size (default 2048)]"
+			<< " [level (default 6)] [dictionary output file]" << endl;
+		return 1;
+	}
+	size_t dictionarySize = argc > 2 ? static_cast<size_t>(atol(argv[2])) : 2048;
+	int level = argc > 3 ? atoi(argv[3]) : 6;
+
+	vector<string> samples;
+	if (string(argv[1]) == "-")
+	{
+		samples = synthesize(20000);
+	}
+	else
+	{
+		ifstream in(argv[1]);
+		string line;
+		while (getline(in, line))
+		{
+			if (!line.empty())
+			{
+				samples.push_back(line);
+			}
+		}
+	}
+	if (samples.size() < 2)
+	{
+		cerr << "not enough samples" << endl;
+		return 1;
+	}
+	vector<string> training(samples.begin(), samples.begin() + samples.size() / 2);
+	vector<string> evaluation(samples.begin() + samples.size() / 2, samples.end());
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	string dictionary = MigratoryDataZlibDictionaryCodec::train(training, dictionarySize);
+	double trainSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	if (argc > 4)
+	{
+		ofstream out(argv[4], ios::binary);
+		out.write(dictionary.data(), dictionary.size());
+	}
+
+	size_t original = 0;
+	for (auto& content : evaluation)
+	{
+		original += content.size();
+	}
+
+	size_t zlibSize = 0;
+	vector<unsigned char> buffer;
+	start = chrono::steady_clock::now();
+	for (auto& content : evaluation)
+	{
+		uLongf length = compressBound(static_cast<uLong>(content.size()));
+		buffer.resize(length);
+		compress2(buffer.data(), &length, reinterpret_cast<const Bytef*>(content.data()), static_cast<uLong>(content.size()), level);
+		zlibSize += min(static_cast<size_t>(length), content.size());
+	}
+	double zlibEncodeNanos = nanosSince(start, evaluation.size());
+
+	MigratoryDataZlibDictionaryCodec codec(1, dictionary, level);
+	vector<string> encoded(evaluation.size());
+	size_t codecSize = 0;
+	start = chrono::steady_clock::now();
+	for (size_t i = 0; i < evaluation.size(); i++)
+	{
+		codec.encode(evaluation[i], encoded[i]);
+		codecSize += min(encoded[i].size() + 2, evaluation[i].size());
+	}
+	double codecEncodeNanos = nanosSince(start, evaluation.size());
+
+	string decoded;
+	size_t mismatches = 0;
+	start = chrono::steady_clock::now();
+	for (size_t i = 0; i < evaluation.size(); i++)
+	{
+		if (!codec.decode(encoded[i].data(), encoded[i].size(), decoded) || decoded != evaluation[i])
+		{
+			mismatches++;
+		}
+	}
+	double codecDecodeNanos = nanosSince(start, evaluation.size());
+
+	cout << "{" << endl
+		<< "  \"samples\": " << evaluation.size() << "," << endl
+		<< "  \"averageSize\": " << static_cast<double>(original) / evaluation.size() << "," << endl
+		<< "  \"level\": " << level << "," << endl
+		<< "  \"dictionarySize\": " << dictionary.size() << "," << endl
+		<< "  \"trainSeconds\": " << trainSeconds << "," << endl
+		<< "  \"zlib\": {\"ratio\": " << static_cast<double>(original) / zlibSize
+		<< ", \"encodeNanos\": " << zlibEncodeNanos << "}," << endl
+		<< "  \"dictionary\": {\"ratio\": " << static_cast<double>(original) / codecSize
+		<< ", \"encodeNanos\": " << codecEncodeNanos << ", \"decodeNanos\": " << codecDecodeNanos
+		<< ", \"mismatches\": " << mismatches << "}" << endl
+		<< "}" << endl;
+
+	return mismatches == 0 ? 0 : 1;
+}
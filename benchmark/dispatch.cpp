@@ -0,0 +1,98 @@
+#include "MigratoryDataListener.h"
+#include "MigratoryDataDispatchListener.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace migratorydata;
+
+// Check that the messages of each subject are delivered in the order they were dispatched. Each subject is served by a
+// single worker, so the last sequence number of a subject is only touched by that worker.
+class OrderListener : public MigratoryDataListener
+{
+
+private:
+	vector<long> last;
+
+public:
+	atomic<long> delivered;
+	atomic<long> violations;
+
+	OrderListener(int subjects) : last(subjects, -1), delivered(0), violations(0)
+	{
+	}
+
+	void onMessage(const MigratoryDataMessage& message)
+	{
+		string subject = message.getSubject();
+		int index = atoi(subject.c_str() + subject.rfind('/') + 1);
+		long seq = atol(message.getContent().c_str());
+		if (seq != last[index] + 1)
+		{
+			violations.fetch_add(1, memory_order_relaxed);
+		}
+		last[index] = seq;
+
+		// an uneven handler, so that the queues of some workers fill up while the others drain
+		if (seq % 64 == 0)
+		{
+			chrono::steady_clock::time_point until = chrono::steady_clock::now() + chrono::microseconds(index % 7);
+			while (chrono::steady_clock::now() < until)
+			{
+			}
+		}
+		delivered.fetch_add(1, memory_order_relaxed);
+	}
+
+	void onStatus(const string& status, string& info)
+	{
+	}
+};
+
+// Dispatch messages over many subjects through MigratoryDataDispatchListener with DispatchPolicy::BLOCK and small
+// queues, then verify that no message was lost and that each subject kept its order; it does not need a server.
+int main(int argc, char* argv[])
+{
+	int subjects = argc > 1 ? atoi(argv[1]) : 1000;
+	long messages = argc > 2 ? atol(argv[2]) : 2000000;
+	int workers = argc > 3 ? atoi(argv[3]) : 4;
+	int capacity = argc > 4 ? atoi(argv[4]) : 64;
+
+	vector<string> names;
+	for (int s = 0; s < subjects; s++)
+	{
+		names.push_back("/dispatch/" + to_string(s));
+	}
+
+	OrderListener listener(subjects);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	{
+		MigratoryDataDispatchListener dispatcher(&listener, workers, capacity, DispatchPolicy::BLOCK);
+		vector<long> next(subjects, 0);
+		for (long i = 0; i < messages; i++)
+		{
+			int s = static_cast<int>((i * 7919) % subjects);
+			MigratoryDataMessage message(names[s], to_string(next[s]++));
+			dispatcher.onMessage(message);
+		}
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "{" << endl
+		<< "  \"subjects\": " << subjects << "," << endl
+		<< "  \"messages\": " << messages << "," << endl
+		<< "  \"workers\": " << workers << "," << endl
+		<< "  \"queueCapacity\": " << capacity << "," << endl
+		<< "  \"seconds\": " << seconds << "," << endl
+		<< "  \"rate\": " << messages / seconds << "," << endl
+		<< "  \"delivered\": " << listener.delivered.load() << "," << endl
+		<< "  \"orderViolations\": " << listener.violations.load() << endl
+		<< "}" << endl;
+
+	return listener.delivered.load() == messages && listener.violations.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+#include "MigratoryDataHistoryReplay.h"
+
+#include "config.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace migratorydata;
+
+static chrono::steady_clock::time_point start;
+
+static uint64_t elapsedMicros()
+{
+	return static_cast<uint64_t>(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+}
+
+// Spends a fixed amount of time on each message, as an application decoding and storing it would, and records
+// when the first live message and the last historical message were handled.
+class TimingListener : public MigratoryDataListener
+{
+
+private:
+	chrono::microseconds handlerCost;
+
+public:
+	atomic<uint64_t> historical;
+	atomic<uint64_t> firstLive;
+	atomic<uint64_t> lastHistorical;
+
+	TimingListener(int handlerMicros) : handlerCost(handlerMicros), historical(0), firstLive(0), lastHistorical(0)
+	{
+	}
+
+	void onMessage(const MigratoryDataMessage& message)
+	{
+		chrono::steady_clock::time_point until = chrono::steady_clock::now() + handlerCost;
+		while (chrono::steady_clock::now() < until)
+		{
+		}
+
+		uint64_t now = elapsedMicros();
+		if (message.getMessageType() == MessageType::HISTORICAL)
+		{
+			historical.fetch_add(1, memory_order_relaxed);
+			lastHistorical.store(now, memory_order_relaxed);
+		}
+		else if (message.getMessageType() == MessageType::UPDATE)
+		{
+			uint64_t none = 0;
+			firstLive.compare_exchange_strong(none, now, memory_order_relaxed);
+		}
+	}
+
+	void onStatus(const string& status, string& info)
+	{
+	}
+};
+
+static void configure(MigratoryDataClient& client, MigratoryDataListener* listener, const string& server)
+{
+	client.setListener(listener);
+	string token = TOKEN;
+	client.setEntitlementToken(token);
+#if !defined (SSL_DISABLED)
+	client.setEncryption(ENCRYPTION);
+#endif
+	vector<string> servers;
+	servers.push_back(server);
+	client.setServers(servers);
+}
+
+// Measure the time to the first live message after subscribing with history, with the history delivered on the
+// thread of the library as by a plain subscribeWithHistory(), then replayed by a MigratoryDataHistoryReplay.
+// The history is published beforehand, then live messages are published on all the subjects while subscribing.
+int main(int argc, char* argv[])
+{
+	string server = argc > 1 ? argv[1] : SERVER;
+	int count = argc > 2 ? atoi(argv[2]) : 1000;
+	int history = argc > 3 ? atoi(argv[3]) : 100;
+	int handlerMicros = argc > 4 ? atoi(argv[4]) : 20;
+
+	vector<string> subjects;
+	for (int i = 0; i < count; i++)
+	{
+		subjects.push_back("/history/" + to_string(i));
+	}
+
+	TimingListener publisherListener(0);
+	MigratoryDataClient publisher;
+	configure(publisher, &publisherListener, server);
+	publisher.connect();
+	for (int n = 0; n < history; n++)
+	{
+		for (auto& subject : subjects)
+		{
+			MigratoryDataMessage message(subject, "history-" + to_string(n), "", QoS::GUARANTEED, true, "");
+			publisher.publish(message);
+		}
+	}
+	this_thread::sleep_for(chrono::seconds(2));
+
+	atomic<bool> publishing(true);
+	thread live([&] {
+		for (size_t i = 0; publishing.load(memory_order_relaxed); i++)
+		{
+			MigratoryDataMessage message(subjects[i % subjects.size()], "live", "", QoS::STANDARD, false, "");
+			publisher.publish(message);
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+	});
+
+	cout << "{" << endl
+		<< "  \"subjects\": " << count << "," << endl
+		<< "  \"history\": " << history << "," << endl
+		<< "  \"handlerMicros\": " << handlerMicros << "," << endl;
+
+	for (int replayed = 0; replayed < 2; replayed++)
+	{
+		TimingListener listener(handlerMicros);
+		atomic<int> completed(0);
+		MigratoryDataClient client;
+		unique_ptr<MigratoryDataHistoryReplay> replay;
+		if (replayed)
+		{
+			replay.reset(new MigratoryDataHistoryReplay(client, &listener, history, 100, 4, 4096, chrono::milliseconds(1000),
+				[&completed](const string& subject, uint64_t messages) { completed.fetch_add(1); }));
+			configure(client, replay.get(), server);
+		}
+		else
+		{
+			configure(client, &listener, server);
+		}
+		client.connect();
+		this_thread::sleep_for(chrono::seconds(1));
+
+		start = chrono::steady_clock::now();
+		if (replay)
+		{
+			replay->subscribeWithHistory(subjects);
+		}
+		else
+		{
+			client.subscribeWithHistory(subjects, history);
+		}
+		this_thread::sleep_for(chrono::seconds(2));
+		uint64_t previous = 0;
+		while (listener.historical.load() != previous || (replay && completed.load() < count && elapsedMicros() < 120000000))
+		{
+			previous = listener.historical.load();
+			this_thread::sleep_for(chrono::seconds(1));
+		}
+		client.disconnect();
+		replay.reset();
+
+		cout << "  \"" << (replayed ? "replay" : "direct") << "\": {"
+			<< "\"historicalMessages\": " << listener.historical.load()
+			<< ", \"firstLiveMillis\": " << listener.firstLive.load() / 1000.0
+			<< ", \"lastHistoricalMillis\": " << listener.lastHistorical.load() / 1000.0 << "}"
+			<< (replayed ? "" : ",") << endl;
+	}
+	cout << "}" << endl;
+
+	publishing.store(false);
+	live.join();
+	publisher.disconnect();
+	return 0;
+}
@@ -0,0 +1,78 @@
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+#include "MigratoryDataOutbox.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace migratorydata;
+
+class NullListener : public MigratoryDataListener
+{
+
+public:
+	void onMessage(const MigratoryDataMessage& message)
+	{
+	}
+
+	void onStatus(const string& status, string& info)
+	{
+	}
+};
+
+// Measure the cost of appending messages to a MigratoryDataOutbox while no server is up, and the time
+// needed to recover them when the outbox file is opened again. The client is never connected.
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		cerr << "usage: outbox-benchmark <path> [messages (default 1000000)] [payload bytes (default 512)]" << endl;
+		return 1;
+	}
+	string path = argv[1];
+	long messages = argc > 2 ? atol(argv[2]) : 1000000;
+	int payload = argc > 3 ? atoi(argv[3]) : 512;
+
+	remove(path.c_str());
+	MigratoryDataClient client;
+	NullListener listener;
+	string content(payload, 'x');
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	uint64_t fileSize = 0;
+	{
+		MigratoryDataOutbox outbox(client, &listener, path, UINT64_MAX);
+		for (long i = 0; i < messages; i++)
+		{
+			MigratoryDataMessage message("/outbox/benchmark", content, to_string(i), QoS::GUARANTEED, true, "");
+			outbox.publish(message);
+		}
+		fileSize = outbox.getFileSize();
+	}
+	double appendSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	size_t recovered = 0;
+	{
+		MigratoryDataOutbox outbox(client, &listener, path, UINT64_MAX);
+		recovered = outbox.getPending();
+	}
+	double recoverSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "{" << endl
+		<< "  \"messages\": " << messages << "," << endl
+		<< "  \"payload\": " << payload << "," << endl
+		<< "  \"fileBytes\": " << fileSize << "," << endl
+		<< "  \"appendRate\": " << messages / appendSeconds << "," << endl
+		<< "  \"appendMicros\": " << appendSeconds * 1e6 / messages << "," << endl
+		<< "  \"recovered\": " << recovered << "," << endl
+		<< "  \"recoverSeconds\": " << recoverSeconds << "," << endl
+		<< "  \"recoverRate\": " << recovered / recoverSeconds << endl
+		<< "}" << endl;
+
+	return 0;
+}
@@ -0,0 +1,82 @@
+#include "MigratoryDataListener.h"
+#include "MigratoryDataSubjectRouter.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace migratorydata;
+
+class CountingListener : public MigratoryDataListener
+{
+
+public:
+	long count = 0;
+
+	void onMessage(const MigratoryDataMessage& message)
+	{
+		count++;
+	}
+
+	void onStatus(const string& status, string& info)
+	{
+	}
+};
+
+// Measure the cost of routing messages with MigratoryDataSubjectRouter over a subject tree shaped like market
+// data: /stocks/<exchange>/<symbol>, with exact routes for half of the symbols and a prefix route per exchange.
+int main(int argc, char* argv[])
+{
+	int exchanges = 20;
+	int symbols = argc > 1 ? atoi(argv[1]) / exchanges : 5000;
+	int rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+	MigratoryDataSubjectRouter router(nullptr);
+	vector<CountingListener> listeners(exchanges * 2);
+	vector<MigratoryDataMessage> messages;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int e = 0; e < exchanges; e++)
+	{
+		string exchange = "/stocks/X" + to_string(e) + "/";
+		router.addRoute(exchange + "*", &listeners[2 * e]);
+		for (int s = 0; s < symbols; s++)
+		{
+			string subject = exchange + "SYM" + to_string(s);
+			if (s % 2 == 0)
+			{
+				router.addRoute(subject, &listeners[2 * e + 1]);
+			}
+			messages.push_back(MigratoryDataMessage(subject, "{}"));
+		}
+	}
+	double buildSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	start = chrono::steady_clock::now();
+	for (int r = 0; r < rounds; r++)
+	{
+		for (auto& message : messages)
+		{
+			router.onMessage(message);
+		}
+	}
+	double routeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	long routed = 0;
+	for (auto& listener : listeners)
+	{
+		routed += listener.count;
+	}
+
+	cout << "{" << endl
+		<< "  \"subjects\": " << messages.size() << "," << endl
+		<< "  \"buildSeconds\": " << buildSeconds << "," << endl
+		<< "  \"routed\": " << routed << "," << endl
+		<< "  \"nanosPerMessage\": " << routeSeconds * 1e9 / routed << endl
+		<< "}" << endl;
+
+	return 0;
+}
@@ -0,0 +1,172 @@
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+#include "MigratoryDataAsyncClient.h"
+#include "MigratoryDataHistogram.h"
+#include "MigratoryDataRequester.h"
+
+#include "config.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace migratorydata;
+
+// Answers each request with its own content.
+class Responder : public MigratoryDataListener
+{
+
+private:
+	MigratoryDataClient& client;
+
+public:
+	Responder(MigratoryDataClient& client) : client(client)
+	{
+	}
+
+	void onMessage(const MigratoryDataMessage& message)
+	{
+		string replySubject = message.getReplySubject();
+		if (!replySubject.empty())
+		{
+			MigratoryDataMessage reply(replySubject, message.getContent(), "", QoS::STANDARD, false, "");
+			client.publish(reply);
+		}
+	}
+
+	void onStatus(const string& status, string& info)
+	{
+	}
+};
+
+class Silent : public MigratoryDataListener
+{
+
+public:
+	void onMessage(const MigratoryDataMessage& message)
+	{
+	}
+
+	void onStatus(const string& status, string& info)
+	{
+	}
+};
+
+static bool connect(MigratoryDataClient& client, MigratoryDataAsyncClient& async, const string& server)
+{
+	string token = TOKEN;
+	client.setEntitlementToken(token);
+#if !defined (SSL_DISABLED)
+	client.setEncryption(ENCRYPTION);
+#endif
+	vector<string> servers;
+	servers.push_back(server);
+	client.setServers(servers);
+	return async.connectAsync().get() == client.NOTIFY_SERVER_UP;
+}
+
+// Measure the round-trip time of requests answered by a responder client through the server, with up to
+// `concurrency` requests in flight, their replies being matched and their timeouts run by MigratoryDataRequester.
+int main(int argc, char* argv[])
+{
+	string server = argc > 1 ? argv[1] : SERVER;
+	int requests = argc > 2 ? atoi(argv[2]) : 100000;
+	int concurrency = argc > 3 ? atoi(argv[3]) : 10000;
+	int timeoutMillis = argc > 4 ? atoi(argv[4]) : 5000;
+
+	MigratoryDataClient responderClient;
+	Responder responder(responderClient);
+	MigratoryDataAsyncClient responderAsync(responderClient, &responder);
+	responderClient.setListener(&responderAsync);
+
+	MigratoryDataClient client;
+	Silent silent;
+	MigratoryDataAsyncClient async(client, &silent);
+	MigratoryDataRequester requester(client, &async, "/inbox/rpc-benchmark", concurrency);
+	client.setListener(&requester);
+
+	if (!connect(responderClient, responderAsync, server) || !connect(client, async, server))
+	{
+		cerr << "cannot connect to " << server << endl;
+		return 1;
+	}
+	vector<string> subjects;
+	subjects.push_back("/rpc/echo");
+	responderAsync.subscribeAsync(subjects).get();
+	// wait for the reply subjects to be subscribed, so that the requests are not held while measuring
+	size_t allowed = requester.reserve(concurrency).get();
+	if (allowed < static_cast<size_t>(concurrency))
+	{
+		cerr << "only " << allowed << " of " << concurrency << " reply subjects were allowed" << endl;
+		return 1;
+	}
+
+	MigratoryDataHistogram latency;
+	atomic<uint64_t> replied(0);
+	atomic<uint64_t> timedOut(0);
+	atomic<uint64_t> failed(0);
+	mutex lock;
+	condition_variable released;
+	int available = concurrency;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (int i = 0; i < requests; i++)
+	{
+		{
+			unique_lock<mutex> guard(lock);
+			released.wait(guard, [&available] { return available > 0; });
+			available--;
+		}
+		chrono::steady_clock::time_point sent = chrono::steady_clock::now();
+		MigratoryDataMessage message("/rpc/echo", to_string(i));
+		requester.request(message, chrono::milliseconds(timeoutMillis), [&, sent](ReplyStatus status, const MigratoryDataMessage& reply) {
+			if (status == ReplyStatus::REPLIED)
+			{
+				latency.record(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - sent).count());
+				replied.fetch_add(1, memory_order_relaxed);
+			}
+			else if (status == ReplyStatus::TIMED_OUT)
+			{
+				timedOut.fetch_add(1, memory_order_relaxed);
+			}
+			else
+			{
+				failed.fetch_add(1, memory_order_relaxed);
+			}
+			lock_guard<mutex> guard(lock);
+			available++;
+			released.notify_one();
+		});
+	}
+	{
+		unique_lock<mutex> guard(lock);
+		released.wait(guard, [&available, concurrency] { return available == concurrency; });
+	}
+	double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+	cout << "{" << endl
+		<< "  \"requests\": " << requests << "," << endl
+		<< "  \"concurrency\": " << concurrency << "," << endl
+		<< "  \"seconds\": " << seconds << "," << endl
+		<< "  \"rate\": " << requests / seconds << "," << endl
+		<< "  \"replied\": " << replied.load() << "," << endl
+		<< "  \"timedOut\": " << timedOut.load() << "," << endl
+		<< "  \"failed\": " << failed.load() << "," << endl
+		<< "  \"lateReplies\": " << requester.getLateReplies() << "," << endl
+		<< "  \"latencyMicros\": {\"p50\": " << latency.getValueAtPercentile(50)
+		<< ", \"p99\": " << latency.getValueAtPercentile(99)
+		<< ", \"p999\": " << latency.getValueAtPercentile(99.9)
+		<< ", \"max\": " << latency.getMax() << "}" << endl
+		<< "}" << endl;
+
+	client.disconnect();
+	responderClient.disconnect();
+	return 0;
+}
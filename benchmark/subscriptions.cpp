@@ -0,0 +1,158 @@
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+#include "MigratoryDataSubscriptionSet.h"
+
+#include "config.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+using namespace migratorydata;
+
+// Counts the subjects whose subscription has been answered by the server, either when subscribing or when
+// synchronizing them after a connection.
+class SubscriptionListener : public MigratoryDataListener
+{
+
+private:
+	MigratoryDataClient& client;
+	mutex lock;
+	condition_variable changed;
+	unordered_set<string> settled;
+	size_t denied = 0;
+
+public:
+	SubscriptionListener(MigratoryDataClient& client) : client(client)
+	{
+	}
+
+	void onMessage(const MigratoryDataMessage& message)
+	{
+	}
+
+	void onStatus(const string& status, string& info)
+	{
+		bool deny = status == client.NOTIFY_SUBSCRIBE_DENY;
+		if (deny || status == client.NOTIFY_SUBSCRIBE_ALLOW || status == client.NOTIFY_DATA_SYNC || status == client.NOTIFY_DATA_RESYNC)
+		{
+			lock_guard<mutex> guard(lock);
+			if (settled.insert(info).second && deny)
+			{
+				denied++;
+			}
+			changed.notify_all();
+		}
+	}
+
+	void reset()
+	{
+		lock_guard<mutex> guard(lock);
+		settled.clear();
+		denied = 0;
+	}
+
+	bool await(size_t count, chrono::seconds timeout)
+	{
+		unique_lock<mutex> guard(lock);
+		return changed.wait_for(guard, timeout, [this, count] { return settled.size() >= count; });
+	}
+
+	size_t getDenied()
+	{
+		lock_guard<mutex> guard(lock);
+		return denied;
+	}
+};
+
+static void configure(MigratoryDataClient& client, SubscriptionListener& listener, const string& server)
+{
+	client.setListener(&listener);
+	string token = TOKEN;
+	client.setEntitlementToken(token);
+#if !defined (SSL_DISABLED)
+	client.setEncryption(ENCRYPTION);
+#endif
+	vector<string> servers;
+	servers.push_back(server);
+	client.setServers(servers);
+}
+
+static double secondsSince(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Measure the time needed to subscribe to a large number of subjects, to change a tenth of them, and to
+// subscribe them all again when a client connects with its subscriptions already set, as after a reconnection.
+int main(int argc, char* argv[])
+{
+	string server = argc > 1 ? argv[1] : SERVER;
+	int count = argc > 2 ? atoi(argv[2]) : 100000;
+	size_t batchSize = argc > 3 ? static_cast<size_t>(atol(argv[3])) : 1000;
+	chrono::seconds timeout(120);
+
+	vector<string> subjects;
+	for (int i = 0; i < count; i++)
+	{
+		subjects.push_back("/subscriptions/" + to_string(i));
+	}
+	vector<string> removed(subjects.begin(), subjects.begin() + count / 10);
+	vector<string> added;
+	for (int i = count; i < count + count / 10; i++)
+	{
+		added.push_back("/subscriptions/" + to_string(i));
+	}
+
+	MigratoryDataClient client;
+	SubscriptionListener listener(client);
+	configure(client, listener, server);
+	MigratoryDataSubscriptionSet subscriptions(client, batchSize);
+	client.connect();
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	subscriptions.subscribe(subjects);
+	double subscribeCallSeconds = secondsSince(start);
+	bool complete = listener.await(subjects.size(), timeout);
+	double subscribeSeconds = secondsSince(start);
+
+	listener.reset();
+	start = chrono::steady_clock::now();
+	subscriptions.updateSubscriptions(added, removed);
+	double updateCallSeconds = secondsSince(start);
+	complete = listener.await(added.size(), timeout) && complete;
+	double updateSeconds = secondsSince(start);
+
+	client.disconnect();
+
+	MigratoryDataClient resynced;
+	SubscriptionListener resyncListener(resynced);
+	configure(resynced, resyncListener, server);
+	MigratoryDataSubscriptionSet resyncedSubscriptions(resynced, batchSize);
+	resyncedSubscriptions.subscribe(subjects);
+	start = chrono::steady_clock::now();
+	resynced.connect();
+	complete = resyncListener.await(subjects.size(), timeout) && complete;
+	double resyncSeconds = secondsSince(start);
+	resynced.disconnect();
+
+	cout << "{" << endl
+		<< "  \"subjects\": " << count << "," << endl
+		<< "  \"batchSize\": " << batchSize << "," << endl
+		<< "  \"complete\": " << (complete ? "true" : "false") << "," << endl
+		<< "  \"denied\": " << listener.getDenied() + resyncListener.getDenied() << "," << endl
+		<< "  \"subscribeCallSeconds\": " << subscribeCallSeconds << "," << endl
+		<< "  \"subscribeSeconds\": " << subscribeSeconds << "," << endl
+		<< "  \"updateCallSeconds\": " << updateCallSeconds << "," << endl
+		<< "  \"updateSeconds\": " << updateSeconds << "," << endl
+		<< "  \"resyncSeconds\": " << resyncSeconds << endl
+		<< "}" << endl;
+
+	return complete ? 0 : 1;
+}
@@ -8,4 +8,4 @@ if not defined DevEnvDir (
 
 set EX_LIBS=ws2_32.lib gdi32.lib advapi32.lib crypt32.lib user32.lib
 
-%CC_DIR%\Tools\MSVC\14.22.27905\bin\Hostx86\x86\cl.exe %MD_FLAGS% /EHsc /I include /MD main.cpp %EX_LIBS% migratorydata-client-cpp-i586.lib /link /LIBPATH:lib\Release
+%CC_DIR%\Tools\MSVC\14.22.27905\bin\Hostx86\x86\cl.exe %MD_FLAGS% /EHsc /I include /I util /MD main.cpp %EX_LIBS% migratorydata-client-cpp-i586.lib /link /LIBPATH:lib\Release
@@ -44,6 +44,30 @@ namespace migratorydata
 		 */
 		MigratoryDataMessage(const MigratoryDataMessage& message);
 
+		/**
+		 * Move constructor.
+		 *
+		 * The subject, content, closure and reply subject are taken over from the given message without being
+		 * copied; the given message is left in a valid but unspecified state.
+		 *
+		 * \param message A MigratoryDataMessage object
+		 */
+		MigratoryDataMessage(MigratoryDataMessage&& message) = default;
+
+		/**
+		 * Copy assignment operator.
+		 *
+		 * \param message A MigratoryDataMessage object
+		 */
+		MigratoryDataMessage& operator=(const MigratoryDataMessage& message) = default;
+
+		/**
+		 * Move assignment operator.
+		 *
+		 * \param message A MigratoryDataMessage object
+		 */
+		MigratoryDataMessage& operator=(MigratoryDataMessage&& message) = default;
+
 		/**
 	    * Create a MigratoryDataMessage object
  		*
@@ -104,6 +128,36 @@ namespace migratorydata
  		*/	
 		std::string getClosure() const;
 
+		/**
+		 * Get the subject of the message without copying it.
+		 *
+		 * \return A reference to the subject of the message, valid as long as the message
+		 */
+		const std::string& getSubjectRef() const
+		{
+			return subject;
+		}
+
+		/**
+		 * Get the content of the message without copying it.
+		 *
+		 * \return A reference to the content of the message, valid as long as the message
+		 */
+		const std::string& getContentRef() const
+		{
+			return content;
+		}
+
+		/**
+		 * Get the closure of the message without copying it.
+		 *
+		 * \return A reference to the closure data of the message, valid as long as the message
+		 */
+		const std::string& getClosureRef() const
+		{
+			return closure;
+		}
+
 		/**
 		 * Indicate whether or not the message should be/was retained by the server.
 		 *
@@ -121,6 +175,16 @@ namespace migratorydata
 		 * \return The subject to be used to reply to this message.
 		 */
 		std::string getReplySubject() const;
+
+		/**
+		 * Get the subject to be used to reply to this message without copying it.
+		 *
+		 * \return A reference to the reply subject of the message, valid as long as the message
+		 */
+		const std::string& getReplySubjectRef() const
+		{
+			return replySubject;
+		}
 		
 		/**
 		 * Get the QoS level of the message.
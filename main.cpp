@@ -1,5 +1,3 @@
-#include <windows.h>
-
 #include "MigratoryDataLogLevel.h"
 #include "MigratoryDataListener.h"
 #include "MigratoryDataClient.h"
@@ -12,11 +10,13 @@
 #include <string>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <chrono>
 
 using namespace std;
 using namespace migratorydata;
 
-class MLogListener : public MigratoryDataLogListener
+class MLogListener final : public MigratoryDataLogListener
 {
 
 public:
@@ -27,7 +27,7 @@ public:
 
 };
 
-class MListener : public MigratoryDataListener
+class MListener final : public MigratoryDataListener
 {
 
 public:
@@ -48,7 +48,7 @@ void start()
 	MigratoryDataClient* client = new MigratoryDataClient();
 
 	// configure the logging
-	MigratoryDataLogListener* myLogListener = new MLogListener();
+	MLogListener* myLogListener = new MLogListener();
 	client->setLogListener(myLogListener, LOG_TRACE);
 
 	client->setEntitlementToken(TOKEN);
@@ -56,7 +56,7 @@ void start()
 	client->setEncryption(ENCRYPTION);
 
 	// define the listener for messages and notifications
-	MigratoryDataListener* myListener = new MListener();
+	MListener* myListener = new MListener();
 	client->setListener(myListener);
 
 	vector<string> servers;
@@ -82,7 +82,7 @@ void start()
 
 		client->publish(message);
 
-		Sleep(5000);
+		this_thread::sleep_for(chrono::seconds(5));
 	}
 
 	client->disconnect();
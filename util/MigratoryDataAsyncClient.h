@@ -0,0 +1,418 @@
+#ifndef _MigratoryDataAsyncClient_h_included_
+#define _MigratoryDataAsyncClient_h_included_
+
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * A listener which turns the status notifications of connect, subscribe and publish operations into futures or
+	 * completion callbacks.
+	 *
+	 * \link publishAsync() \endlink completes with the publish notification of the message, matched by its closure;
+	 * \link subscribeAsync() \endlink completes once each subject got \link MigratoryDataClient.NOTIFY_SUBSCRIBE_ALLOW
+	 * \endlink or \link MigratoryDataClient.NOTIFY_SUBSCRIBE_DENY \endlink; \link connectAsync() \endlink completes
+	 * with the first \link MigratoryDataClient.NOTIFY_SERVER_UP \endlink, \link MigratoryDataClient.NOTIFY_SERVER_DOWN
+	 * \endlink or \link MigratoryDataClient.NOTIFY_CONNECT_DENY \endlink. The callbacks run on the executor given to the
+	 * constructor, or on the thread of the library if there is none, so any number of operations can be in flight
+	 * without a thread waiting for each of them.
+	 *
+	 * Messages published without a closure are given a closure made of a sequence number; the notifications of these
+	 * closures are consumed and not forwarded to the wrapped listener. The closures given by the application must be
+	 * unique among the messages in flight: a message published with the closure of a message still in flight is not
+	 * published, and completes at once with \link MigratoryDataClient.NOTIFY_PUBLISH_FAILED \endlink.
+	 *
+	 * When the connection is lost, with \link MigratoryDataClient.NOTIFY_SERVER_DOWN \endlink, every pending
+	 * operation completes: the publications with \link MigratoryDataClient.NOTIFY_PUBLISH_FAILED \endlink, and the
+	 * subjects of the subscriptions not allowed or denied yet with \link MigratoryDataClient.NOTIFY_SERVER_DOWN
+	 * \endlink, so no future waits for a notification which may never come. A notification arriving later for these
+	 * operations is only forwarded to the wrapped listener. Operations still pending when this object is destroyed
+	 * never complete.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the wrapped listener.
+	 */
+	class MigratoryDataAsyncClient : public MigratoryDataListener
+	{
+
+	public :
+
+		/**
+		 * The function which runs the completion callbacks, for instance by posting them to a thread pool or an event
+		 * loop.
+		 */
+		typedef std::function<void(std::function<void()>)> Executor;
+
+		/**
+		 * The function called when a publish or connect operation completes, with its status notification.
+		 */
+		typedef std::function<void(const std::string& status)> StatusCallback;
+
+		/**
+		 * The function called when a subscribe operation completes, with the status notification of each subject.
+		 */
+		typedef std::function<void(const std::vector<std::pair<std::string, std::string>>& statuses)> SubscribeCallback;
+
+	private :
+
+		struct Publication
+		{
+			StatusCallback callback;
+			bool assigned;
+		};
+
+		struct Subscription
+		{
+			std::vector<std::pair<std::string, std::string>> statuses;
+			size_t remaining;
+			SubscribeCallback callback;
+		};
+
+		MigratoryDataClient& client;
+		MigratoryDataListener* listener;
+		Executor executor;
+
+		std::mutex mutex;
+		std::unordered_map<std::string, Publication> publications;
+		std::unordered_map<std::string, std::vector<std::shared_ptr<Subscription>>> subscriptions;
+		std::vector<StatusCallback> connections;
+		uint64_t sequence;
+
+		// Prefix of the closures assigned by this object; a control character keeps them apart from the
+		// closures given by the application.
+		static const char* assignedPrefix()
+		{
+			return "\x03" "async-";
+		}
+
+		void complete(std::function<void()> completion)
+		{
+			if (executor)
+			{
+				executor(std::move(completion));
+			}
+			else
+			{
+				completion();
+			}
+		}
+
+		bool completePublication(const std::string& status, const std::string& closure)
+		{
+			Publication publication;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = publications.find(closure);
+				if (it == publications.end())
+				{
+					return false;
+				}
+				publication = std::move(it->second);
+				publications.erase(it);
+			}
+			StatusCallback callback = std::move(publication.callback);
+			complete([callback, status] { callback(status); });
+			return publication.assigned;
+		}
+
+		void completeSubscription(const std::string& status, const std::string& subject)
+		{
+			std::vector<std::shared_ptr<Subscription>> done;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = subscriptions.find(subject);
+				if (it == subscriptions.end())
+				{
+					return;
+				}
+				for (auto& subscription : it->second)
+				{
+					subscription->statuses.push_back(std::make_pair(subject, status));
+					if (--subscription->remaining == 0)
+					{
+						done.push_back(subscription);
+					}
+				}
+				subscriptions.erase(it);
+			}
+			for (auto& subscription : done)
+			{
+				complete([subscription] { subscription->callback(subscription->statuses); });
+			}
+		}
+
+		// Complete all the pending publications and subscriptions after the connection was lost.
+		void failPending()
+		{
+			std::unordered_map<std::string, Publication> failed;
+			std::vector<std::shared_ptr<Subscription>> done;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				failed.swap(publications);
+				for (auto& it : subscriptions)
+				{
+					for (auto& subscription : it.second)
+					{
+						subscription->statuses.push_back(std::make_pair(it.first, client.NOTIFY_SERVER_DOWN));
+						if (--subscription->remaining == 0)
+						{
+							done.push_back(subscription);
+						}
+					}
+				}
+				subscriptions.clear();
+			}
+			std::string status = client.NOTIFY_PUBLISH_FAILED;
+			for (auto& it : failed)
+			{
+				StatusCallback callback = std::move(it.second.callback);
+				complete([callback, status] { callback(status); });
+			}
+			for (auto& subscription : done)
+			{
+				complete([subscription] { subscription->callback(subscription->statuses); });
+			}
+		}
+
+		void completeConnection(const std::string& status)
+		{
+			std::vector<StatusCallback> done;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				done.swap(connections);
+			}
+			for (auto& callback : done)
+			{
+				complete([callback, status] { callback(status); });
+			}
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataAsyncClient object.
+		 *
+		 * \param client     the client used for the operations
+		 * \param listener   the listener to which the messages and the status notifications are forwarded
+		 * \param executor   the function which runs the completion callbacks (OPTIONAL); by default they run on the
+		 *                   thread of the library and must not block
+		 */
+		MigratoryDataAsyncClient(MigratoryDataClient& client, MigratoryDataListener* listener, Executor executor = Executor())
+			: client(client), listener(listener), executor(executor), sequence(0)
+		{
+		}
+
+		/**
+		 * Connect the client and call a function with the outcome of the connection.
+		 *
+		 * \param callback   the function called with MigratoryDataClient.NOTIFY_SERVER_UP,
+		 *                   MigratoryDataClient.NOTIFY_SERVER_DOWN or MigratoryDataClient.NOTIFY_CONNECT_DENY
+		 */
+		void connectAsync(StatusCallback callback)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				connections.push_back(std::move(callback));
+			}
+			client.connect();
+		}
+
+		/**
+		 * Connect the client.
+		 *
+		 * \return a future holding MigratoryDataClient.NOTIFY_SERVER_UP, MigratoryDataClient.NOTIFY_SERVER_DOWN or
+		 *         MigratoryDataClient.NOTIFY_CONNECT_DENY
+		 */
+		std::future<std::string> connectAsync()
+		{
+			std::shared_ptr<std::promise<std::string>> promise = std::make_shared<std::promise<std::string>>();
+			connectAsync([promise](const std::string& status) { promise->set_value(status); });
+			return promise->get_future();
+		}
+
+		/**
+		 * Subscribe to subjects and call a function once all of them have been allowed or denied.
+		 *
+		 * \param subjects   subjects not subscribed yet
+		 * \param callback   the function called with MigratoryDataClient.NOTIFY_SUBSCRIBE_ALLOW,
+		 *                   MigratoryDataClient.NOTIFY_SUBSCRIBE_DENY or, if the connection was lost first,
+		 *                   MigratoryDataClient.NOTIFY_SERVER_DOWN for each subject
+		 */
+		void subscribeAsync(const std::vector<std::string>& subjects, SubscribeCallback callback)
+		{
+			std::shared_ptr<Subscription> subscription = std::make_shared<Subscription>();
+			subscription->remaining = 0;
+			subscription->callback = std::move(callback);
+			std::vector<std::string> requested;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				for (const std::string& subject : subjects)
+				{
+					std::vector<std::shared_ptr<Subscription>>& waiting = subscriptions[subject];
+					if (waiting.empty() || waiting.back() != subscription)
+					{
+						waiting.push_back(subscription);
+						subscription->remaining++;
+						requested.push_back(subject);
+					}
+				}
+			}
+			if (requested.empty())
+			{
+				complete([subscription] { subscription->callback(subscription->statuses); });
+				return;
+			}
+			client.subscribe(requested);
+		}
+
+		/**
+		 * Subscribe to subjects.
+		 *
+		 * \param subjects   subjects not subscribed yet
+		 * \return a future holding MigratoryDataClient.NOTIFY_SUBSCRIBE_ALLOW, MigratoryDataClient.NOTIFY_SUBSCRIBE_DENY
+		 *         or MigratoryDataClient.NOTIFY_SERVER_DOWN for each subject
+		 */
+		std::future<std::vector<std::pair<std::string, std::string>>> subscribeAsync(const std::vector<std::string>& subjects)
+		{
+			std::shared_ptr<std::promise<std::vector<std::pair<std::string, std::string>>>> promise
+				= std::make_shared<std::promise<std::vector<std::pair<std::string, std::string>>>>();
+			subscribeAsync(subjects, [promise](const std::vector<std::pair<std::string, std::string>>& statuses) {
+				promise->set_value(statuses);
+			});
+			return promise->get_future();
+		}
+
+		/**
+		 * Publish a message and call a function with its publish notification.
+		 *
+		 * \param message    A MigratoryDataMessage message
+		 * \param callback   the function called with MigratoryDataClient.NOTIFY_PUBLISH_OK,
+		 *                   MigratoryDataClient.NOTIFY_PUBLISH_FAILED, MigratoryDataClient.NOTIFY_PUBLISH_DENIED or
+		 *                   MigratoryDataClient.NOTIFY_MESSAGE_SIZE_LIMIT_EXCEEDED; with
+		 *                   MigratoryDataClient.NOTIFY_PUBLISH_FAILED at once if the closure of the message is the one
+		 *                   of a message still in flight
+		 */
+		void publishAsync(MigratoryDataMessage& message, StatusCallback callback)
+		{
+			std::string closure = message.getClosure();
+			bool assigned = closure.empty();
+			bool duplicate;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (assigned)
+				{
+					closure = assignedPrefix() + std::to_string(++sequence);
+				}
+				auto inserted = publications.emplace(closure, Publication());
+				duplicate = !inserted.second;
+				if (!duplicate)
+				{
+					inserted.first->second.callback = std::move(callback);
+					inserted.first->second.assigned = assigned;
+				}
+			}
+			if (duplicate)
+			{
+				// the closure of a message still in flight; its notification could not be told apart
+				std::string status = client.NOTIFY_PUBLISH_FAILED;
+				complete([callback, status] { callback(status); });
+				return;
+			}
+
+			if (assigned)
+			{
+				MigratoryDataMessage tracked(message.getSubjectRef(), message.getContentRef(), closure, message.getQos(),
+					message.isRetained(), message.getReplySubjectRef());
+				tracked.setCompressed(message.isCompressed());
+				client.publish(tracked);
+			}
+			else
+			{
+				client.publish(message);
+			}
+		}
+
+		/**
+		 * Publish a message.
+		 *
+		 * \param message A MigratoryDataMessage message
+		 * \return a future holding the publish notification of the message
+		 */
+		std::future<std::string> publishAsync(MigratoryDataMessage& message)
+		{
+			std::shared_ptr<std::promise<std::string>> promise = std::make_shared<std::promise<std::string>>();
+			publishAsync(message, [promise](const std::string& status) { promise->set_value(status); });
+			return promise->get_future();
+		}
+
+		/**
+		 * Forward the message to the wrapped listener.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			listener->onMessage(message);
+		}
+
+		/**
+		 * Complete the operations matching the status notification, or all the pending ones after
+		 * \link MigratoryDataClient.NOTIFY_SERVER_DOWN \endlink, then forward the notification to the wrapped
+		 * listener unless it concerns a closure assigned by this object.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			if (status == client.NOTIFY_PUBLISH_OK || status == client.NOTIFY_PUBLISH_FAILED
+				|| status == client.NOTIFY_PUBLISH_DENIED || status == client.NOTIFY_MESSAGE_SIZE_LIMIT_EXCEEDED)
+			{
+				if (completePublication(status, info))
+				{
+					return;
+				}
+			}
+			else if (status == client.NOTIFY_SUBSCRIBE_ALLOW || status == client.NOTIFY_SUBSCRIBE_DENY)
+			{
+				completeSubscription(status, info);
+			}
+			else if (status == client.NOTIFY_SERVER_UP || status == client.NOTIFY_SERVER_DOWN
+				|| status == client.NOTIFY_CONNECT_DENY)
+			{
+				completeConnection(status);
+				if (status == client.NOTIFY_SERVER_DOWN)
+				{
+					failPending();
+				}
+			}
+			listener->onStatus(status, info);
+		}
+
+		/**
+		 * Get the number of publish operations waiting for their notification.
+		 *
+		 * \return the number of messages in flight
+		 */
+		size_t getPendingPublications()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return publications.size();
+		}
+	};
+
+}
+
+#endif // _MigratoryDataAsyncClient_h_included_
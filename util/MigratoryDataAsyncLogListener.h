@@ -0,0 +1,157 @@
+#ifndef _MigratoryDataAsyncLogListener_h_included_
+#define _MigratoryDataAsyncLogListener_h_included_
+
+#include "MigratoryDataLogListener.h"
+#include "MigratoryDataLogLevel.h"
+#include "MigratoryDataRingBuffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <thread>
+
+namespace migratorydata
+{
+
+	/**
+	 * A log record handed over by a \link MigratoryDataAsyncLogListener \endlink to its writer thread.
+	 */
+	struct MigratoryDataLogRecord
+	{
+		/** The time at which the library produced the log, as reported by the system clock. */
+		std::chrono::system_clock::time_point time;
+		/** The level of the log. */
+		MigratoryDataLogLevel level = LOG_ERROR;
+		/** The log message. */
+		std::string text;
+	};
+
+	/**
+	 * A log listener which takes the logs off the threads of the library.
+	 *
+	 * Each log is filtered against a level threshold, stamped, and pushed into a bounded lock-free ring; a background
+	 * writer thread drains the ring periodically and passes the records to the sink, so a slow sink never stalls the
+	 * network thread of the library. When the ring is full the log is dropped and counted rather than waited for.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setLogListener() \endlink, and destroy it only after
+	 * \link MigratoryDataClient.disconnect() \endlink.
+	 */
+	class MigratoryDataAsyncLogListener : public MigratoryDataLogListener
+	{
+
+	private :
+
+		std::function<void(MigratoryDataLogRecord&)> sink;
+		MigratoryDataLogLevel threshold;
+		std::chrono::milliseconds flushInterval;
+		MigratoryDataRingBuffer<MigratoryDataLogRecord> records;
+		std::atomic<unsigned long long> dropped;
+		std::atomic<bool> running;
+		std::thread writer;
+
+		void drain()
+		{
+			MigratoryDataLogRecord record;
+			while (records.tryPop(record))
+			{
+				sink(record);
+			}
+		}
+
+		void run()
+		{
+			while (running.load(std::memory_order_acquire))
+			{
+				drain();
+				std::this_thread::sleep_for(flushInterval);
+			}
+			drain();
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataAsyncLogListener object which passes structured records to a function.
+		 *
+		 * \param sink            the function called on the writer thread for each record, in order
+		 * \param threshold       the most verbose level forwarded to the sink; more verbose logs are discarded
+		 *                        before being queued
+		 * \param capacity        the minimum number of logs which can wait for the writer thread
+		 * \param flushInterval   the time the writer thread sleeps after it has drained the ring
+		 */
+		MigratoryDataAsyncLogListener(std::function<void(MigratoryDataLogRecord&)> sink, MigratoryDataLogLevel threshold,
+			size_t capacity, std::chrono::milliseconds flushInterval)
+			: sink(sink), threshold(threshold), flushInterval(flushInterval), records(capacity), dropped(0), running(true)
+		{
+			writer = std::thread([this] { run(); });
+		}
+
+		/**
+		 * Create a MigratoryDataAsyncLogListener object which forwards the logs to another log listener.
+		 *
+		 * \param logListener     the log listener called on the writer thread for each log, in order
+		 * \param threshold       the most verbose level forwarded to the log listener; more verbose logs are discarded
+		 *                        before being queued
+		 * \param capacity        the minimum number of logs which can wait for the writer thread
+		 * \param flushInterval   the time the writer thread sleeps after it has drained the ring
+		 */
+		MigratoryDataAsyncLogListener(MigratoryDataLogListener* logListener, MigratoryDataLogLevel threshold,
+			size_t capacity, std::chrono::milliseconds flushInterval)
+			: MigratoryDataAsyncLogListener([logListener](MigratoryDataLogRecord& record) { logListener->onLog(record.text, record.level); },
+				threshold, capacity, flushInterval)
+		{
+		}
+
+		MigratoryDataAsyncLogListener(const MigratoryDataAsyncLogListener&) = delete;
+		MigratoryDataAsyncLogListener& operator=(const MigratoryDataAsyncLogListener&) = delete;
+
+		/**
+		 * Queue the log for the writer thread, unless it is more verbose than the threshold or the ring is full.
+		 *
+		 * \param log A string representing a log message.
+		 * \param logLevel The level of the log message.
+		 */
+		void onLog(std::string& log, MigratoryDataLogLevel logLevel)
+		{
+			if (logLevel > threshold)
+			{
+				return;
+			}
+
+			MigratoryDataLogRecord record;
+			record.time = std::chrono::system_clock::now();
+			record.level = logLevel;
+			record.text = log;
+			if (!records.tryPush(std::move(record)))
+			{
+				dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		/**
+		 * Get the number of logs dropped because the ring was full.
+		 *
+		 * \return the number of dropped logs
+		 */
+		unsigned long long getDroppedLogs() const
+		{
+			return dropped.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * \brief Destructor.
+		 *
+		 * Write the logs still queued, then stop the writer thread.
+		 */
+		virtual ~MigratoryDataAsyncLogListener()
+		{
+			running.store(false, std::memory_order_release);
+			writer.join();
+		}
+	};
+
+}
+
+#endif // _MigratoryDataAsyncLogListener_h_included_
@@ -0,0 +1,60 @@
+#ifndef _MigratoryDataCodec_h_included_
+#define _MigratoryDataCodec_h_included_
+
+#include <cstddef>
+#include <string>
+
+namespace migratorydata
+{
+
+	/**
+	 * A codec which encodes the content of the published messages and decodes the content of the received messages,
+	 * used by a \link MigratoryDataCodecListener \endlink.
+	 *
+	 * The encoded content is tagged with the identifier of the codec, so the publishers and the subscribers of a
+	 * subject only need to register codecs with the same identifier and configuration, such as the same dictionary.
+	 * The methods of a codec may be called concurrently from several threads.
+	 */
+	class MigratoryDataCodec
+	{
+
+	public :
+
+		/**
+		 * Get the identifier of the codec, written in front of each content it encodes.
+		 *
+		 * \return an identifier from \c 1 to \c 255 which is unique among the codecs of the application
+		 */
+		virtual unsigned char getId() const = 0;
+
+		/**
+		 * Encode a content.
+		 *
+		 * \param content   the content to be encoded
+		 * \param encoded   the string to which the encoded content is appended
+		 * \return \c true if the content was encoded; \c false if the encoding failed, in which case the content is
+		 *         published as is
+		 */
+		virtual bool encode(const std::string& content, std::string& encoded) = 0;
+
+		/**
+		 * Decode a content encoded by \link encode() \endlink.
+		 *
+		 * \param data      the encoded content, without the tag
+		 * \param size      the size of the encoded content
+		 * \param content   the string which receives the decoded content
+		 * \return \c true if the content was decoded
+		 */
+		virtual bool decode(const char* data, size_t size, std::string& content) = 0;
+
+		/**
+		 * \brief Destructor.
+		 */
+		virtual ~MigratoryDataCodec()
+		{
+		}
+	};
+
+}
+
+#endif // _MigratoryDataCodec_h_included_
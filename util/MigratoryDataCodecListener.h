@@ -0,0 +1,230 @@
+#ifndef _MigratoryDataCodecListener_h_included_
+#define _MigratoryDataCodecListener_h_included_
+
+#include "MigratoryDataListener.h"
+#include "MigratoryDataCodec.h"
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace migratorydata
+{
+
+	/**
+	 * A listener which decodes the content of the received messages encoded by a \link MigratoryDataCodec \endlink,
+	 * and encodes the content of the messages to be published with the codec chosen for their subject.
+	 *
+	 * An encoded content starts with an escape character followed by the identifier of its codec, so the messages of
+	 * a subject can be published with or without a codec, and a subscriber decodes them as long as it has registered
+	 * a codec with the same identifier. A content which cannot be decoded is forwarded unchanged and counted.
+	 *
+	 * Encoded contents are binary; they are not compressed again by the library.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the wrapped listener,
+	 * and publish the messages returned by \link encode() \endlink.
+	 */
+	class MigratoryDataCodecListener : public MigratoryDataListener
+	{
+
+	private :
+
+		// A received message whose content was decoded, with the metadata of the original message.
+		class DecodedMessage : public MigratoryDataMessage
+		{
+
+		public :
+
+			DecodedMessage(const MigratoryDataMessage& message, const std::string& content)
+				: MigratoryDataMessage(message.getSubjectRef(), content, message.getClosureRef(), message.getQos(),
+					message.isRetained(), message.getReplySubjectRef())
+			{
+				seq = message.getSeq();
+				epoch = message.getEpoch();
+				messageType = message.getMessageType();
+				compressed = message.isCompressed();
+			}
+		};
+
+		// The tag of an encoded content; the codec identifier 0 marks a content sent as is which happens to start
+		// with the tag.
+		enum : char { TAG = '\x1b', RAW = '\0' };
+
+		MigratoryDataListener* listener;
+		mutable std::shared_timed_mutex mutex;
+		MigratoryDataCodec* codecs[256];
+		std::unordered_map<std::string, MigratoryDataCodec*> subjectCodecs;
+		MigratoryDataCodec* defaultCodec;
+		std::atomic<unsigned long long> failures;
+
+		MigratoryDataCodec* codecOf(const std::string& subject) const
+		{
+			std::shared_lock<std::shared_timed_mutex> lock(mutex);
+			auto it = subjectCodecs.find(subject);
+			return it != subjectCodecs.end() ? it->second : defaultCodec;
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataCodecListener object.
+		 *
+		 * \param listener   the listener to which the decoded messages and the status notifications are forwarded
+		 */
+		explicit MigratoryDataCodecListener(MigratoryDataListener* listener)
+			: listener(listener), codecs(), defaultCodec(nullptr), failures(0)
+		{
+		}
+
+		/**
+		 * Register a codec to decode the received messages it has encoded.
+		 *
+		 * \param codec   a codec, which must outlive this listener
+		 */
+		void addCodec(MigratoryDataCodec* codec)
+		{
+			std::unique_lock<std::shared_timed_mutex> lock(mutex);
+			codecs[codec->getId()] = codec;
+		}
+
+		/**
+		 * Encode the messages published on a subject with a codec, which is also registered for decoding.
+		 *
+		 * \param subject   a subject
+		 * \param codec     the codec of the subject, or \c nullptr to publish its messages as they are, or with the
+		 *                  default codec if any
+		 */
+		void setCodec(const std::string& subject, MigratoryDataCodec* codec)
+		{
+			std::unique_lock<std::shared_timed_mutex> lock(mutex);
+			if (codec != nullptr)
+			{
+				subjectCodecs[subject] = codec;
+				codecs[codec->getId()] = codec;
+			}
+			else
+			{
+				subjectCodecs.erase(subject);
+			}
+		}
+
+		/**
+		 * Encode the messages published on the subjects having no codec of their own with a codec, which is also
+		 * registered for decoding.
+		 *
+		 * \param codec   the default codec, or \c nullptr to publish those messages as they are
+		 */
+		void setDefaultCodec(MigratoryDataCodec* codec)
+		{
+			std::unique_lock<std::shared_timed_mutex> lock(mutex);
+			defaultCodec = codec;
+			if (codec != nullptr)
+			{
+				codecs[codec->getId()] = codec;
+			}
+		}
+
+		/**
+		 * Encode a message to be published with the codec of its subject.
+		 *
+		 * The content is kept as is if the subject has no codec or if the encoded content would not be smaller.
+		 *
+		 * \param message   a message to be published
+		 * \return the message to be given to \link MigratoryDataClient.publish() \endlink
+		 */
+		MigratoryDataMessage encode(const MigratoryDataMessage& message)
+		{
+			const std::string& content = message.getContentRef();
+			MigratoryDataCodec* codec = codecOf(message.getSubjectRef());
+			if (codec != nullptr)
+			{
+				std::string encoded;
+				encoded.reserve(content.size());
+				encoded.push_back(TAG);
+				encoded.push_back(static_cast<char>(codec->getId()));
+				if (codec->encode(content, encoded) && encoded.size() < content.size())
+				{
+					MigratoryDataMessage result(message.getSubjectRef(), encoded, message.getClosureRef(), message.getQos(),
+						message.isRetained(), message.getReplySubjectRef());
+					return result;
+				}
+			}
+			std::string escaped;
+			if (!content.empty() && content[0] == TAG)
+			{
+				escaped.reserve(content.size() + 2);
+				escaped.push_back(TAG);
+				escaped.push_back(RAW);
+				escaped.append(content);
+			}
+			MigratoryDataMessage result(message.getSubjectRef(), escaped.empty() ? content : escaped,
+				message.getClosureRef(), message.getQos(), message.isRetained(), message.getReplySubjectRef());
+			result.setCompressed(message.isCompressed());
+			return result;
+		}
+
+		/**
+		 * Decode the content of the message if it is encoded, then forward the message to the wrapped listener.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			const std::string& content = message.getContentRef();
+			if (content.size() < 2 || content[0] != TAG)
+			{
+				listener->onMessage(message);
+				return;
+			}
+
+			std::string decoded;
+			if (content[1] == RAW)
+			{
+				decoded = content.substr(2);
+			}
+			else
+			{
+				MigratoryDataCodec* codec;
+				{
+					std::shared_lock<std::shared_timed_mutex> lock(mutex);
+					codec = codecs[static_cast<unsigned char>(content[1])];
+				}
+				if (codec == nullptr || !codec->decode(content.data() + 2, content.size() - 2, decoded))
+				{
+					failures.fetch_add(1, std::memory_order_relaxed);
+					listener->onMessage(message);
+					return;
+				}
+			}
+			DecodedMessage decodedMessage(message, decoded);
+			listener->onMessage(decodedMessage);
+		}
+
+		/**
+		 * Forward the status notification to the wrapped listener.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			listener->onStatus(status, info);
+		}
+
+		/**
+		 * Get the number of received messages which could not be decoded, because their codec is not registered or
+		 * their content is corrupted; these messages are forwarded unchanged.
+		 *
+		 * \return the number of messages not decoded
+		 */
+		unsigned long long getDecodeFailures() const
+		{
+			return failures.load(std::memory_order_relaxed);
+		}
+	};
+
+}
+
+#endif // _MigratoryDataCodecListener_h_included_
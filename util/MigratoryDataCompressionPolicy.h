@@ -0,0 +1,64 @@
+#ifndef _MigratoryDataCompressionPolicy_h_included_
+#define _MigratoryDataCompressionPolicy_h_included_
+
+#include "MigratoryDataMessage.h"
+
+#include <cstddef>
+
+namespace migratorydata
+{
+
+	/**
+	 * Decides which published messages are worth compressing, based on the size of their content.
+	 *
+	 * When \link MigratoryDataMessage.setCompressed() \endlink is enabled, the library compresses the content and
+	 * sends it uncompressed if the result is not smaller, so a small content costs a full compression attempt for
+	 * nothing. Applying this policy instead enables compression only for the contents of at least \c threshold bytes.
+	 */
+	class MigratoryDataCompressionPolicy
+	{
+
+	private :
+
+		size_t threshold;
+
+	public :
+
+		/**
+		 * Create a MigratoryDataCompressionPolicy object.
+		 *
+		 * \param threshold   the minimum size in bytes of a content to be compressed; a few hundred bytes is the usual
+		 *                    break-even point for text content such as JSON
+		 */
+		explicit MigratoryDataCompressionPolicy(size_t threshold = 512)
+			: threshold(threshold)
+		{
+		}
+
+		/**
+		 * Enable or disable the compression of a message according to the size of its content.
+		 *
+		 * \param message A MigratoryDataMessage message to be published
+		 * \return \c true if the message is to be compressed
+		 */
+		bool apply(MigratoryDataMessage& message) const
+		{
+			bool compressed = message.getContentRef().size() >= threshold;
+			message.setCompressed(compressed);
+			return compressed;
+		}
+
+		/**
+		 * Get the minimum size of a content to be compressed.
+		 *
+		 * \return the threshold in bytes
+		 */
+		size_t getThreshold() const
+		{
+			return threshold;
+		}
+	};
+
+}
+
+#endif // _MigratoryDataCompressionPolicy_h_included_
@@ -0,0 +1,216 @@
+#ifndef _MigratoryDataDispatchListener_h_included_
+#define _MigratoryDataDispatchListener_h_included_
+
+#include "MigratoryDataListener.h"
+#include "MigratoryDataDispatchPolicy.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * A listener which dispatches the received messages to a pool of worker threads.
+	 *
+	 * Each subject is hashed to exactly one worker, and each worker delivers its messages in the order they were
+	 * received, so the messages of a subject keep their order while a slow handler for one subject does not hold up
+	 * the subjects served by the other workers.
+	 *
+	 * The status notifications are forwarded to the wrapped listener immediately, on the thread of the library.
+	 * Because \link MigratoryDataListener.onMessage() \endlink is called from several threads, the wrapped listener
+	 * must be thread-safe.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the wrapped listener,
+	 * and destroy it only after \link MigratoryDataClient.disconnect() \endlink.
+	 */
+	class MigratoryDataDispatchListener : public MigratoryDataListener
+	{
+
+	private :
+
+		struct Worker
+		{
+			std::mutex mutex;
+			std::condition_variable notEmpty;
+			std::condition_variable notFull;
+			std::deque<MigratoryDataMessage> queue;
+			unsigned long long dropped = 0;
+			bool stopped = false;
+			std::thread thread;
+		};
+
+		MigratoryDataListener* listener;
+		std::vector<std::unique_ptr<Worker>> workers;
+		size_t queueCapacity;
+		DispatchPolicy policy;
+
+		void run(Worker& worker)
+		{
+			std::unique_lock<std::mutex> lock(worker.mutex);
+			while (true)
+			{
+				worker.notEmpty.wait(lock, [&worker] { return worker.stopped || !worker.queue.empty(); });
+				if (worker.queue.empty())
+				{
+					return;
+				}
+
+				MigratoryDataMessage message(std::move(worker.queue.front()));
+				worker.queue.pop_front();
+				worker.notFull.notify_one();
+
+				lock.unlock();
+				listener->onMessage(message);
+				lock.lock();
+			}
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataDispatchListener object and start its worker threads.
+		 *
+		 * \param listener        the listener which handles the messages and the status notifications
+		 * \param workers         the number of worker threads; at least one worker is started
+		 * \param queueCapacity   the maximum number of messages queued by each worker; at least one
+		 * \param policy          the policy applied when the queue of a worker is full
+		 */
+		MigratoryDataDispatchListener(MigratoryDataListener* listener, int workers, size_t queueCapacity, DispatchPolicy policy)
+			: listener(listener), queueCapacity(queueCapacity > 0 ? queueCapacity : 1), policy(policy)
+		{
+			int count = workers > 0 ? workers : 1;
+			for (int i = 0; i < count; i++)
+			{
+				this->workers.emplace_back(new Worker());
+			}
+			for (auto& worker : this->workers)
+			{
+				Worker* w = worker.get();
+				w->thread = std::thread([this, w] { run(*w); });
+			}
+		}
+
+		MigratoryDataDispatchListener(const MigratoryDataDispatchListener&) = delete;
+		MigratoryDataDispatchListener& operator=(const MigratoryDataDispatchListener&) = delete;
+
+		/**
+		 * Queue the message to the worker serving its subject.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			Worker& worker = *workers[std::hash<std::string>()(message.getSubjectRef()) % workers.size()];
+
+			std::unique_lock<std::mutex> lock(worker.mutex);
+			if (worker.stopped)
+			{
+				return;
+			}
+			if (worker.queue.size() >= queueCapacity)
+			{
+				switch (policy)
+				{
+				case DispatchPolicy::BLOCK:
+					worker.notFull.wait(lock, [this, &worker] { return worker.stopped || worker.queue.size() < queueCapacity; });
+					break;
+				case DispatchPolicy::DROP_NEWEST:
+					worker.dropped++;
+					return;
+				case DispatchPolicy::DROP_OLDEST:
+					worker.queue.pop_front();
+					worker.dropped++;
+					break;
+				}
+				if (worker.stopped)
+				{
+					// the listener is being destroyed; its workers no longer take messages
+					return;
+				}
+			}
+			worker.queue.push_back(message);
+			worker.notEmpty.notify_one();
+		}
+
+		/**
+		 * Forward the status notification to the wrapped listener.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			listener->onStatus(status, info);
+		}
+
+		/**
+		 * Get the number of worker threads.
+		 *
+		 * \return the number of worker threads
+		 */
+		int getWorkers() const
+		{
+			return static_cast<int>(workers.size());
+		}
+
+		/**
+		 * Get the number of messages currently queued by a worker.
+		 *
+		 * \param worker the index of the worker, from \c 0 to \link getWorkers() \endlink - 1
+		 * \return the number of messages waiting to be delivered by that worker
+		 */
+		size_t getQueueDepth(int worker) const
+		{
+			Worker& w = *workers.at(worker);
+			std::lock_guard<std::mutex> lock(w.mutex);
+			return w.queue.size();
+		}
+
+		/**
+		 * Get the number of messages dropped by all workers because of a full queue.
+		 *
+		 * \return the number of dropped messages; always \c 0 with DispatchPolicy::BLOCK
+		 */
+		unsigned long long getDroppedMessages() const
+		{
+			unsigned long long dropped = 0;
+			for (auto& worker : workers)
+			{
+				std::lock_guard<std::mutex> lock(worker->mutex);
+				dropped += worker->dropped;
+			}
+			return dropped;
+		}
+
+		/**
+		 * \brief Destructor.
+		 *
+		 * Deliver the messages still queued, then stop the worker threads.
+		 */
+		virtual ~MigratoryDataDispatchListener()
+		{
+			for (auto& worker : workers)
+			{
+				std::lock_guard<std::mutex> lock(worker->mutex);
+				worker->stopped = true;
+				worker->notEmpty.notify_all();
+				worker->notFull.notify_all();
+			}
+			for (auto& worker : workers)
+			{
+				worker->thread.join();
+			}
+		}
+	};
+
+}
+
+#endif // _MigratoryDataDispatchListener_h_included_
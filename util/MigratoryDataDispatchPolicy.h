@@ -0,0 +1,28 @@
+#pragma once
+
+namespace migratorydata {
+
+	/**
+	 * The policy applied when a queue of received messages is full, either the queue of a worker of a
+	 * \link MigratoryDataDispatchListener \endlink or the ring of a \link MigratoryDataPollListener \endlink.
+	 */
+	enum class DispatchPolicy {
+
+		/**
+		 * Make the thread of the library wait until the consumer makes room in the queue (backpressure).
+		 */
+		BLOCK,
+
+		/**
+		 * Drop the incoming message.
+		 */
+		DROP_NEWEST,
+
+		/**
+		 * Drop the oldest queued message to make room for the incoming message.
+		 */
+		DROP_OLDEST
+
+	};
+
+}
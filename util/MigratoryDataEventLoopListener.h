@@ -0,0 +1,335 @@
+#ifndef _MigratoryDataEventLoopListener_h_included_
+#define _MigratoryDataEventLoopListener_h_included_
+
+#include "MigratoryDataListener.h"
+#include "MigratoryDataDispatchPolicy.h"
+#include "MigratoryDataRingBuffer.h"
+
+#if !defined (_WIN32)
+
+#include <fcntl.h>
+#include <unistd.h>
+#if defined (__linux__)
+#include <sys/eventfd.h>
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace migratorydata
+{
+
+	/**
+	 * A listener which lets an event loop, such as an epoll or poll reactor, handle the received messages and status
+	 * notifications on its own thread, inline with its other events.
+	 *
+	 * The messages and the status notifications are queued into bounded lock-free rings, and the file descriptor
+	 * returned by \link getFileDescriptor() \endlink becomes readable whenever a ring is not empty. Register this descriptor for reading with the event loop and, when it is reported readable, call
+	 * \link processEvents() \endlink, which calls the wrapped listener for the queued events on the calling thread.
+	 * The descriptor is signaled only when the ring goes from empty to not empty, so a burst of messages costs a single
+	 * system call and a single wake-up of the event loop.
+	 *
+	 * The status notifications have a small ring of their own, so a flood of messages can neither crowd them out nor,
+	 * with DispatchPolicy::DROP_OLDEST, evict them; each one is processed after the messages received before it, as
+	 * if both shared a single ring. A status notification which finds its ring full waits for a free slot with
+	 * DispatchPolicy::BLOCK, as a message does, since the helpers waiting for it, such as subscription or publish
+	 * notifications, would otherwise wait forever; with the other policies it is dropped and counted by
+	 * \link getDroppedStatuses() \endlink.
+	 *
+	 * The network I/O of the client remains on the thread of the library; only the callbacks move to the event loop.
+	 * \link processEvents() \endlink must be called from a single thread. This listener is available on POSIX systems,
+	 * with an eventfd on Linux and a pipe elsewhere.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the wrapped listener.
+	 */
+	class MigratoryDataEventLoopListener : public MigratoryDataListener
+	{
+
+	private :
+
+		struct Event
+		{
+			MigratoryDataMessage message;
+			std::string status;
+			std::string info;
+			bool isStatus;
+			// for a status notification, the number of messages queued before it
+			uint64_t after;
+		};
+
+		MigratoryDataListener* listener;
+		MigratoryDataRingBuffer<Event> events;
+		MigratoryDataRingBuffer<Event> statuses;
+		DispatchPolicy policy;
+		std::atomic<unsigned long long> dropped;
+		std::atomic<unsigned long long> droppedStatuses;
+		// the number of messages queued, and the number of messages processed or dropped from the ring
+		std::atomic<uint64_t> queued;
+		std::atomic<uint64_t> removed;
+		// the status notification popped by processEvents() and waiting for the messages queued before it
+		Event held;
+		bool holding;
+		std::atomic<bool> signaled;
+		int readFd;
+		int writeFd;
+
+		void signal()
+		{
+			if (!signaled.exchange(true))
+			{
+#if defined (__linux__)
+				uint64_t one = 1;
+				ssize_t written = write(writeFd, &one, sizeof(one));
+#else
+				char one = 1;
+				ssize_t written = write(writeFd, &one, sizeof(one));
+#endif
+				(void) written;
+			}
+		}
+
+		void clear()
+		{
+#if defined (__linux__)
+			uint64_t count;
+			ssize_t consumed = read(readFd, &count, sizeof(count));
+			(void) consumed;
+#else
+			char buffer[64];
+			while (read(readFd, buffer, sizeof(buffer)) > 0)
+			{
+			}
+#endif
+		}
+
+		void pushStatus(Event& event)
+		{
+			event.after = queued.load(std::memory_order_acquire);
+			while (!statuses.tryPush(std::move(event)))
+			{
+				if (policy != DispatchPolicy::BLOCK)
+				{
+					droppedStatuses.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				std::this_thread::yield();
+			}
+			signal();
+		}
+
+		void push(Event& event)
+		{
+			while (!events.tryPush(std::move(event)))
+			{
+				switch (policy)
+				{
+				case DispatchPolicy::BLOCK:
+					std::this_thread::yield();
+					break;
+				case DispatchPolicy::DROP_NEWEST:
+					dropped.fetch_add(1, std::memory_order_relaxed);
+					return;
+				case DispatchPolicy::DROP_OLDEST:
+					{
+						Event oldest;
+						if (events.tryPop(oldest))
+						{
+							removed.fetch_add(1, std::memory_order_release);
+							dropped.fetch_add(1, std::memory_order_relaxed);
+						}
+					}
+					break;
+				}
+			}
+			queued.fetch_add(1, std::memory_order_release);
+			signal();
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataEventLoopListener object.
+		 *
+		 * \param listener   the listener called by \link processEvents() \endlink
+		 * \param capacity         the minimum number of messages which can wait to be processed
+		 * \param policy           the policy applied to a message when the ring is full; with DispatchPolicy::BLOCK the
+		 *                         thread of the library yields until the event loop processes the queued messages
+		 * \param statusCapacity   the minimum number of status notifications which can wait to be processed; when their
+		 *                         ring is full, a status notification waits like a message with DispatchPolicy::BLOCK
+		 *                         and is dropped otherwise
+		 */
+		MigratoryDataEventLoopListener(MigratoryDataListener* listener, size_t capacity, DispatchPolicy policy,
+			size_t statusCapacity = 256)
+			: listener(listener), events(capacity), statuses(statusCapacity), policy(policy), dropped(0), droppedStatuses(0),
+			queued(0), removed(0), holding(false), signaled(false), readFd(-1), writeFd(-1)
+		{
+#if defined (__linux__)
+			readFd = writeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (readFd < 0)
+			{
+				throw std::runtime_error("cannot create the eventfd");
+			}
+#else
+			int fds[2];
+			if (pipe(fds) != 0)
+			{
+				throw std::runtime_error("cannot create the pipe");
+			}
+			for (int fd : fds)
+			{
+				fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+				fcntl(fd, F_SETFD, FD_CLOEXEC);
+			}
+			readFd = fds[0];
+			writeFd = fds[1];
+#endif
+		}
+
+		MigratoryDataEventLoopListener(const MigratoryDataEventLoopListener&) = delete;
+		MigratoryDataEventLoopListener& operator=(const MigratoryDataEventLoopListener&) = delete;
+
+		/**
+		 * Get the file descriptor to be watched for reading by the event loop.
+		 *
+		 * \return a non-blocking file descriptor, readable while events wait to be processed
+		 */
+		int getFileDescriptor() const
+		{
+			return readFd;
+		}
+
+		/**
+		 * Call the wrapped listener, on the calling thread, for up to \c max queued messages and status notifications,
+		 * in the order they were received.
+		 *
+		 * If events are still queued on return, the file descriptor stays readable, so a level-triggered event loop
+		 * calls this method again on its next iteration after handling its other events.
+		 *
+		 * \param max   the maximum number of events to be processed
+		 * \return the number of events processed
+		 */
+		size_t processEvents(size_t max)
+		{
+			clear();
+			signaled.exchange(false);
+
+			size_t count = 0;
+			Event event;
+			while (count < max)
+			{
+				if (!holding)
+				{
+					holding = statuses.tryPop(held);
+				}
+				if (holding && removed.load(std::memory_order_acquire) >= held.after)
+				{
+					holding = false;
+					listener->onStatus(held.status, held.info);
+				}
+				else if (events.tryPop(event))
+				{
+					removed.fetch_add(1, std::memory_order_release);
+					listener->onMessage(event.message);
+				}
+				else if (holding)
+				{
+					// the messages queued before the status notification were dropped meanwhile
+					holding = false;
+					listener->onStatus(held.status, held.info);
+				}
+				else
+				{
+					break;
+				}
+				count++;
+			}
+			if (holding || events.size() > 0 || statuses.size() > 0)
+			{
+				signal();
+			}
+			return count;
+		}
+
+		/**
+		 * Queue the message to be processed by the event loop.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			Event event;
+			event.message = message;
+			event.isStatus = false;
+			push(event);
+		}
+
+		/**
+		 * Queue the status notification to be processed by the event loop.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			Event event;
+			event.status = status;
+			event.info = info;
+			event.isStatus = true;
+			pushStatus(event);
+		}
+
+		/**
+		 * Get the number of messages and status notifications waiting to be processed.
+		 *
+		 * \return the number of queued events
+		 */
+		size_t getQueueDepth() const
+		{
+			return events.size() + statuses.size();
+		}
+
+		/**
+		 * Get the number of messages dropped because the ring was full.
+		 *
+		 * \return the number of dropped messages; always \c 0 with DispatchPolicy::BLOCK
+		 */
+		unsigned long long getDroppedMessages() const
+		{
+			return dropped.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * Get the number of status notifications dropped because their ring was full.
+		 *
+		 * \return the number of dropped status notifications; always \c 0 with DispatchPolicy::BLOCK
+		 */
+		unsigned long long getDroppedStatuses() const
+		{
+			return droppedStatuses.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * \brief Destructor.
+		 *
+		 * Close the file descriptor, which must be removed from the event loop beforehand.
+		 */
+		virtual ~MigratoryDataEventLoopListener()
+		{
+			close(readFd);
+			if (writeFd != readFd)
+			{
+				close(writeFd);
+			}
+		}
+	};
+
+}
+
+#endif
+
+#endif // _MigratoryDataEventLoopListener_h_included_
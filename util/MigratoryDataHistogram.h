@@ -0,0 +1,230 @@
+#ifndef _MigratoryDataHistogram_h_included_
+#define _MigratoryDataHistogram_h_included_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace migratorydata
+{
+
+	/**
+	 * A histogram of non-negative integer values, such as latencies expressed in microseconds.
+	 *
+	 * Values are counted in log-linear buckets: values below 128 are counted exactly, and larger values in buckets
+	 * whose width is at most 1/64 of their lower bound, so any percentile is reported with a relative error below
+	 * 1.6% while the whole range of 64-bit values fits in a few thousand counters.
+	 *
+	 * Recording is lock-free and wait-free, so several threads can record into the same histogram concurrently.
+	 */
+	class MigratoryDataHistogram
+	{
+
+	private :
+
+		static const int SUB_BUCKET_BITS = 6;
+		static const size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+		static const size_t BUCKETS = SUB_BUCKETS * (64 - SUB_BUCKET_BITS + 1);
+
+		std::unique_ptr<std::atomic<uint64_t>[]> counts;
+		std::atomic<uint64_t> count;
+		std::atomic<uint64_t> sum;
+		std::atomic<uint64_t> min;
+		std::atomic<uint64_t> max;
+
+		static int highestBit(uint64_t value)
+		{
+			int bit = 0;
+			while (value >>= 1)
+			{
+				bit++;
+			}
+			return bit;
+		}
+
+		static size_t indexOf(uint64_t value)
+		{
+			if (value < 2 * SUB_BUCKETS)
+			{
+				return static_cast<size_t>(value);
+			}
+			int shift = highestBit(value) - SUB_BUCKET_BITS;
+			return static_cast<size_t>(shift) * SUB_BUCKETS + static_cast<size_t>(value >> shift);
+		}
+
+		static uint64_t highestValueOf(size_t index)
+		{
+			if (index < 2 * SUB_BUCKETS)
+			{
+				return index;
+			}
+			int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+			uint64_t mantissa = index % SUB_BUCKETS + SUB_BUCKETS;
+			return ((mantissa + 1) << shift) - 1;
+		}
+
+	public :
+
+		/**
+		 * Create an empty MigratoryDataHistogram object.
+		 */
+		MigratoryDataHistogram()
+			: counts(new std::atomic<uint64_t>[BUCKETS]), count(0), sum(0), min(UINT64_MAX), max(0)
+		{
+			for (size_t i = 0; i < BUCKETS; i++)
+			{
+				counts[i].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		MigratoryDataHistogram(const MigratoryDataHistogram&) = delete;
+		MigratoryDataHistogram& operator=(const MigratoryDataHistogram&) = delete;
+
+		/**
+		 * Record a value.
+		 *
+		 * \param value the value to be recorded
+		 */
+		void record(uint64_t value)
+		{
+			counts[indexOf(value)].fetch_add(1, std::memory_order_relaxed);
+			count.fetch_add(1, std::memory_order_relaxed);
+			sum.fetch_add(value, std::memory_order_relaxed);
+
+			uint64_t current = min.load(std::memory_order_relaxed);
+			while (value < current && !min.compare_exchange_weak(current, value, std::memory_order_relaxed))
+			{
+			}
+			current = max.load(std::memory_order_relaxed);
+			while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+			{
+			}
+		}
+
+		/**
+		 * Add the values recorded by another histogram to this histogram.
+		 *
+		 * \param other the histogram whose values are added
+		 */
+		void add(const MigratoryDataHistogram& other)
+		{
+			for (size_t i = 0; i < BUCKETS; i++)
+			{
+				uint64_t n = other.counts[i].load(std::memory_order_relaxed);
+				if (n > 0)
+				{
+					counts[i].fetch_add(n, std::memory_order_relaxed);
+				}
+			}
+			count.fetch_add(other.count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			sum.fetch_add(other.sum.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			if (other.getCount() > 0)
+			{
+				uint64_t value = other.getMin();
+				uint64_t current = min.load(std::memory_order_relaxed);
+				while (value < current && !min.compare_exchange_weak(current, value, std::memory_order_relaxed))
+				{
+				}
+				value = other.getMax();
+				current = max.load(std::memory_order_relaxed);
+				while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+				{
+				}
+			}
+		}
+
+		/**
+		 * Forget all the recorded values.
+		 *
+		 * Values recorded concurrently with this call may be partially lost.
+		 */
+		void reset()
+		{
+			for (size_t i = 0; i < BUCKETS; i++)
+			{
+				counts[i].store(0, std::memory_order_relaxed);
+			}
+			count.store(0, std::memory_order_relaxed);
+			sum.store(0, std::memory_order_relaxed);
+			min.store(UINT64_MAX, std::memory_order_relaxed);
+			max.store(0, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Get the number of recorded values.
+		 *
+		 * \return the number of recorded values
+		 */
+		uint64_t getCount() const
+		{
+			return count.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * Get the smallest recorded value.
+		 *
+		 * \return the smallest recorded value, or \c 0 if no value was recorded
+		 */
+		uint64_t getMin() const
+		{
+			return getCount() > 0 ? min.load(std::memory_order_relaxed) : 0;
+		}
+
+		/**
+		 * Get the largest recorded value.
+		 *
+		 * \return the largest recorded value, or \c 0 if no value was recorded
+		 */
+		uint64_t getMax() const
+		{
+			return max.load(std::memory_order_relaxed);
+		}
+
+		/**
+		 * Get the mean of the recorded values.
+		 *
+		 * \return the mean of the recorded values, or \c 0 if no value was recorded
+		 */
+		double getMean() const
+		{
+			uint64_t n = getCount();
+			return n > 0 ? static_cast<double>(sum.load(std::memory_order_relaxed)) / n : 0;
+		}
+
+		/**
+		 * Get the value below or at which the given percentage of the recorded values fall.
+		 *
+		 * \param percentile a percentage between \c 0 and \c 100, for example \c 99.9
+		 * \return the upper bound of the bucket holding the requested percentile, capped to the largest recorded
+		 *         value, or \c 0 if no value was recorded
+		 */
+		uint64_t getValueAtPercentile(double percentile) const
+		{
+			uint64_t n = getCount();
+			if (n == 0)
+			{
+				return 0;
+			}
+			uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * n + 0.5);
+			if (rank < 1)
+			{
+				rank = 1;
+			}
+			uint64_t seen = 0;
+			for (size_t i = 0; i < BUCKETS; i++)
+			{
+				seen += counts[i].load(std::memory_order_relaxed);
+				if (seen >= rank)
+				{
+					uint64_t value = highestValueOf(i);
+					return value < getMax() ? value : getMax();
+				}
+			}
+			return getMax();
+		}
+	};
+
+}
+
+#endif // _MigratoryDataHistogram_h_included_
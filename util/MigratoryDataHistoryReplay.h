@@ -0,0 +1,407 @@
+#ifndef _MigratoryDataHistoryReplay_h_included_
+#define _MigratoryDataHistoryReplay_h_included_
+
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * A listener which replays the history of the subjects subscribed with history on worker threads, in bounded
+	 * chunks, while the live messages are delivered without waiting behind it.
+	 *
+	 * Subjects subscribed with \link subscribeWithHistory() \endlink are handed to \link
+	 * MigratoryDataClient.subscribeWithHistory() \endlink at most \c maxReplaying at a time; the next ones are
+	 * subscribed as the previous ones complete, so the historical messages arrive in chunks rather than all at once.
+	 *
+	 * The messages of type MessageType::HISTORICAL are queued to the worker serving their subject, each subject being
+	 * hashed to exactly one worker, and delivered in order by that worker. When the queue of a worker is full, the
+	 * thread of the library waits, which slows down the reading of further history. The other messages are delivered
+	 * immediately, on the thread of the library, so the first live message of a subject can be delivered before the
+	 * end of its history; the type of each message tells them apart.
+	 *
+	 * The history of a subject is complete when the first message of another type is received for it, when its
+	 * subscription is denied, or when no message has been received for it during \c idleTimeout. The completion
+	 * callback is then called on the worker of the subject, after its last historical message was delivered.
+	 *
+	 * Because \link MigratoryDataListener.onMessage() \endlink is called from several threads, the wrapped listener
+	 * must be thread-safe. Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the
+	 * wrapped listener, and destroy it only after \link MigratoryDataClient.disconnect() \endlink.
+	 */
+	class MigratoryDataHistoryReplay : public MigratoryDataListener
+	{
+
+	public :
+
+		/**
+		 * The function called when the history of a subject is complete, with the subject and the number of
+		 * historical messages delivered for it.
+		 */
+		typedef std::function<void(const std::string& subject, uint64_t messages)> CompletionCallback;
+
+	private :
+
+		struct Task
+		{
+			MigratoryDataMessage message;
+			std::string subject;
+			uint64_t messages = 0;
+			bool completion = false;
+		};
+
+		struct Worker
+		{
+			std::mutex mutex;
+			std::condition_variable notEmpty;
+			std::condition_variable notFull;
+			std::deque<Task> queue;
+			bool stopped = false;
+			std::thread thread;
+		};
+
+		struct Replay
+		{
+			uint64_t messages;
+			std::chrono::steady_clock::time_point deadline;
+		};
+
+		MigratoryDataClient& client;
+		MigratoryDataListener* listener;
+		int numberOfHistoricalMessages;
+		size_t maxReplaying;
+		size_t queueCapacity;
+		std::chrono::milliseconds idleTimeout;
+		CompletionCallback completionCallback;
+		std::vector<std::unique_ptr<Worker>> workers;
+
+		std::mutex mutex;
+		std::unordered_map<std::string, Replay> replaying;
+		std::deque<std::string> pending;
+		// the size of `replaying`, read without the mutex so that the live messages skip it when nothing replays
+		std::atomic<size_t> active;
+
+		Worker& workerOf(const std::string& subject)
+		{
+			return *workers[std::hash<std::string>()(subject) % workers.size()];
+		}
+
+		// Completion tasks bypass the capacity of the queue, as they are queued by the workers themselves.
+		void enqueue(Worker& worker, Task&& task, bool bounded)
+		{
+			std::unique_lock<std::mutex> lock(worker.mutex);
+			if (bounded)
+			{
+				worker.notFull.wait(lock, [this, &worker] { return worker.stopped || worker.queue.size() < queueCapacity; });
+			}
+			if (worker.stopped)
+			{
+				// the replay is being destroyed; its workers no longer take tasks
+				return;
+			}
+			worker.queue.push_back(std::move(task));
+			worker.notEmpty.notify_one();
+		}
+
+		// Called with the mutex held.
+		void complete(std::unordered_map<std::string, Replay>::iterator it)
+		{
+			Task task;
+			task.subject = it->first;
+			task.messages = it->second.messages;
+			task.completion = true;
+			replaying.erase(it);
+			active.store(replaying.size(), std::memory_order_release);
+			enqueue(workerOf(task.subject), std::move(task), false);
+		}
+
+		// Called with the mutex held; the returned subjects must be subscribed once the mutex is released.
+		std::vector<std::string> startPending()
+		{
+			std::vector<std::string> started;
+			std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + idleTimeout;
+			while (replaying.size() < maxReplaying && !pending.empty())
+			{
+				Replay replay;
+				replay.messages = 0;
+				replay.deadline = deadline;
+				if (replaying.emplace(pending.front(), replay).second)
+				{
+					started.push_back(pending.front());
+				}
+				pending.pop_front();
+			}
+			active.store(replaying.size(), std::memory_order_release);
+			return started;
+		}
+
+		void subscribe(std::vector<std::string>& subjects)
+		{
+			if (!subjects.empty())
+			{
+				client.subscribeWithHistory(subjects, numberOfHistoricalMessages);
+			}
+		}
+
+		void completeSubject(const std::string& subject)
+		{
+			std::vector<std::string> started;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = replaying.find(subject);
+				if (it == replaying.end())
+				{
+					return;
+				}
+				complete(it);
+				started = startPending();
+			}
+			subscribe(started);
+		}
+
+		void expire()
+		{
+			std::vector<std::string> started;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+				for (auto it = replaying.begin(); it != replaying.end(); )
+				{
+					if (it->second.deadline <= now)
+					{
+						complete(it++);
+					}
+					else
+					{
+						++it;
+					}
+				}
+				started = startPending();
+			}
+			subscribe(started);
+		}
+
+		void run(Worker& worker, bool expiring)
+		{
+			std::chrono::milliseconds tick = idleTimeout / 4 + std::chrono::milliseconds(1);
+			std::chrono::steady_clock::time_point nextExpiry = std::chrono::steady_clock::now() + tick;
+
+			std::unique_lock<std::mutex> lock(worker.mutex);
+			while (true)
+			{
+				if (expiring && std::chrono::steady_clock::now() >= nextExpiry)
+				{
+					lock.unlock();
+					expire();
+					lock.lock();
+					nextExpiry = std::chrono::steady_clock::now() + tick;
+				}
+				if (worker.queue.empty())
+				{
+					if (worker.stopped)
+					{
+						return;
+					}
+					worker.notEmpty.wait_for(lock, tick, [&worker] { return worker.stopped || !worker.queue.empty(); });
+					continue;
+				}
+
+				Task task(std::move(worker.queue.front()));
+				worker.queue.pop_front();
+				worker.notFull.notify_one();
+
+				lock.unlock();
+				if (!task.completion)
+				{
+					listener->onMessage(task.message);
+				}
+				else if (completionCallback)
+				{
+					completionCallback(task.subject, task.messages);
+				}
+				lock.lock();
+			}
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataHistoryReplay object and start its worker threads.
+		 *
+		 * \param client                       the client used to subscribe to the subjects
+		 * \param listener                     the listener which handles the messages and the status notifications
+		 * \param numberOfHistoricalMessages   the number of historical messages to be retrieved for each subject
+		 * \param maxReplaying                 the maximum number of subjects whose history is retrieved at a time;
+		 *                                     at least one
+		 * \param workers                      the number of worker threads; at least one worker is started
+		 * \param queueCapacity                the maximum number of historical messages queued by each worker; at
+		 *                                     least one
+		 * \param idleTimeout                  the time after which the history of a subject receiving no message is
+		 *                                     considered complete
+		 * \param completionCallback           the function called when the history of a subject is complete (OPTIONAL)
+		 */
+		MigratoryDataHistoryReplay(MigratoryDataClient& client, MigratoryDataListener* listener, int numberOfHistoricalMessages,
+			size_t maxReplaying, int workers, size_t queueCapacity, std::chrono::milliseconds idleTimeout,
+			CompletionCallback completionCallback = CompletionCallback())
+			: client(client), listener(listener), numberOfHistoricalMessages(numberOfHistoricalMessages),
+			maxReplaying(maxReplaying > 0 ? maxReplaying : 1), queueCapacity(queueCapacity > 0 ? queueCapacity : 1),
+			idleTimeout(idleTimeout), completionCallback(completionCallback), active(0)
+		{
+			int count = workers > 0 ? workers : 1;
+			for (int i = 0; i < count; i++)
+			{
+				this->workers.emplace_back(new Worker());
+			}
+			for (auto& worker : this->workers)
+			{
+				Worker* w = worker.get();
+				bool expiring = w == this->workers.front().get();
+				w->thread = std::thread([this, w, expiring] { run(*w, expiring); });
+			}
+		}
+
+		MigratoryDataHistoryReplay(const MigratoryDataHistoryReplay&) = delete;
+		MigratoryDataHistoryReplay& operator=(const MigratoryDataHistoryReplay&) = delete;
+
+		/**
+		 * Subscribe to subjects with history, at most \c maxReplaying subjects having their history retrieved at a
+		 * time; the other subjects are subscribed as the history of the previous ones completes.
+		 *
+		 * \param subjects   subjects to subscribe
+		 */
+		void subscribeWithHistory(const std::vector<std::string>& subjects)
+		{
+			std::vector<std::string> started;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				pending.insert(pending.end(), subjects.begin(), subjects.end());
+				started = startPending();
+			}
+			subscribe(started);
+		}
+
+		/**
+		 * Queue a historical message to the worker serving its subject, or deliver any other message immediately.
+		 *
+		 * Once no history is being retrieved, the other messages are delivered without taking any lock.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			const std::string& subject = message.getSubjectRef();
+			if (message.getMessageType() == MessageType::HISTORICAL)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					auto it = replaying.find(subject);
+					if (it != replaying.end())
+					{
+						it->second.messages++;
+						it->second.deadline = std::chrono::steady_clock::now() + idleTimeout;
+					}
+				}
+				Task task;
+				task.message = message;
+				enqueue(workerOf(subject), std::move(task), true);
+				return;
+			}
+
+			if (active.load(std::memory_order_acquire) != 0)
+			{
+				completeSubject(subject);
+			}
+			listener->onMessage(message);
+		}
+
+		/**
+		 * Complete the history of a subject whose subscription is denied, then forward the status notification to the
+		 * wrapped listener.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			if (status == client.NOTIFY_SUBSCRIBE_DENY)
+			{
+				completeSubject(info);
+			}
+			listener->onStatus(status, info);
+		}
+
+		/**
+		 * Get the number of subjects whose history is being retrieved.
+		 *
+		 * \return the number of subjects replaying their history
+		 */
+		size_t getReplaying()
+		{
+			return active.load(std::memory_order_acquire);
+		}
+
+		/**
+		 * Get the number of subjects waiting to be subscribed with history.
+		 *
+		 * \return the number of pending subjects
+		 */
+		size_t getPending()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return pending.size();
+		}
+
+		/**
+		 * Get the number of historical messages queued by all workers.
+		 *
+		 * \return the number of historical messages waiting to be delivered
+		 */
+		size_t getQueueDepth()
+		{
+			size_t depth = 0;
+			for (auto& worker : workers)
+			{
+				std::lock_guard<std::mutex> lock(worker->mutex);
+				depth += worker->queue.size();
+			}
+			return depth;
+		}
+
+		/**
+		 * \brief Destructor.
+		 *
+		 * Deliver the messages still queued, then stop the worker threads.
+		 */
+		virtual ~MigratoryDataHistoryReplay()
+		{
+			for (auto& worker : workers)
+			{
+				std::lock_guard<std::mutex> lock(worker->mutex);
+				worker->stopped = true;
+				worker->notEmpty.notify_all();
+				worker->notFull.notify_all();
+			}
+			for (auto& worker : workers)
+			{
+				worker->thread.join();
+			}
+		}
+	};
+
+}
+
+#endif // _MigratoryDataHistoryReplay_h_included_
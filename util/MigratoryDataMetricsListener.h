@@ -0,0 +1,404 @@
+#ifndef _MigratoryDataMetricsListener_h_included_
+#define _MigratoryDataMetricsListener_h_included_
+
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+#include "MigratoryDataHistogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace migratorydata
+{
+
+	/**
+	 * A snapshot of the metrics collected by a \link MigratoryDataMetricsListener \endlink.
+	 */
+	struct MigratoryDataMetricsSnapshot
+	{
+		/** The number of messages received, of any type. */
+		uint64_t messagesIn = 0;
+		/** The number of bytes of subject and content received. */
+		uint64_t bytesIn = 0;
+		/** The number of received messages of type MessageType::SNAPSHOT. */
+		uint64_t snapshotsIn = 0;
+		/** The number of received messages of type MessageType::UPDATE. */
+		uint64_t updatesIn = 0;
+		/** The number of received messages of type MessageType::RECOVERED. */
+		uint64_t recoveredIn = 0;
+		/** The number of received messages of type MessageType::HISTORICAL. */
+		uint64_t historicalIn = 0;
+
+		/** The number of messages published. */
+		uint64_t messagesOut = 0;
+		/** The number of bytes of subject and content published, before compression. */
+		uint64_t bytesOut = 0;
+		/** The number of NOTIFY_PUBLISH_OK notifications. */
+		uint64_t publishOk = 0;
+		/** The number of NOTIFY_PUBLISH_FAILED, NOTIFY_PUBLISH_DENIED and NOTIFY_MESSAGE_SIZE_LIMIT_EXCEEDED notifications. */
+		uint64_t publishFailed = 0;
+		/** The number of published messages with a closure still waiting for their publish notification. */
+		uint64_t pendingPublishes = 0;
+		/** The number of published messages no longer waited for, because their notification did not arrive in time
+		 *  or too many messages were waiting. */
+		uint64_t evictedPublishes = 0;
+		/** The number of published messages not timed because a message with the same closure was still waiting. */
+		uint64_t duplicateClosures = 0;
+
+		/** The number of NOTIFY_SERVER_UP notifications. */
+		uint64_t serverUp = 0;
+		/** The number of NOTIFY_SERVER_DOWN notifications. */
+		uint64_t serverDown = 0;
+		/** The number of NOTIFY_SERVER_UP notifications following the first one. */
+		uint64_t reconnects = 0;
+		/** The number of NOTIFY_DATA_SYNC notifications. */
+		uint64_t dataSync = 0;
+		/** The number of NOTIFY_DATA_RESYNC notifications. */
+		uint64_t dataResync = 0;
+		/** The number of NOTIFY_SUBSCRIBE_DENY notifications. */
+		uint64_t subscribeDeny = 0;
+
+		/** The number of publish notifications whose latency was recorded. */
+		uint64_t ackCount = 0;
+		/** The mean latency of the publish notifications, in microseconds. */
+		double ackLatencyMean = 0;
+		/** The median latency of the publish notifications, in microseconds. */
+		uint64_t ackLatencyP50 = 0;
+		/** The 99th percentile latency of the publish notifications, in microseconds. */
+		uint64_t ackLatencyP99 = 0;
+		/** The maximum latency of the publish notifications, in microseconds. */
+		uint64_t ackLatencyMax = 0;
+	};
+
+	/**
+	 * A listener which collects metrics about the messages and the status notifications of a client before forwarding
+	 * them to the application listener.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the wrapped listener,
+	 * and publish through \link publish() \endlink to also count the published messages and measure the latency of
+	 * their publish notifications. The message counters are striped: each thread increments relaxed atomics on cache
+	 * lines of its own, so collecting them neither adds locks to the reception path nor makes the threads of several
+	 * connections contend, and \link getMetrics() \endlink, which sums the stripes, can be called from any thread at
+	 * any time.
+	 *
+	 * The published messages waiting for their publish notification are bounded in number and in age; the ones which
+	 * exceed either bound are no longer waited for, and counted as evicted.
+	 */
+	class MigratoryDataMetricsListener : public MigratoryDataListener
+	{
+
+	private :
+
+		// The counters incremented for each message, on two cache lines so that two stripes never share one.
+		struct Stripe
+		{
+			std::atomic<uint64_t> messagesIn;
+			std::atomic<uint64_t> bytesIn;
+			std::atomic<uint64_t> typesIn[4];
+			std::atomic<uint64_t> messagesOut;
+			std::atomic<uint64_t> bytesOut;
+			char padding[64];
+		};
+
+		enum : size_t { STRIPES = 16 };
+
+		typedef std::list<std::pair<std::string, std::chrono::steady_clock::time_point>> PendingList;
+
+		MigratoryDataClient& client;
+		MigratoryDataListener* listener;
+		size_t maxPending;
+		std::chrono::milliseconds pendingTimeout;
+
+		Stripe stripes[STRIPES];
+		std::atomic<uint64_t> publishOk;
+		std::atomic<uint64_t> publishFailed;
+		std::atomic<uint64_t> serverUp;
+		std::atomic<uint64_t> serverDown;
+		std::atomic<uint64_t> dataSync;
+		std::atomic<uint64_t> dataResync;
+		std::atomic<uint64_t> subscribeDeny;
+
+		MigratoryDataHistogram ackLatency;
+		std::mutex pendingMutex;
+		// the published messages waiting for their notification, oldest first, and their index by closure
+		PendingList pendingOrder;
+		std::unordered_map<std::string, PendingList::iterator> pending;
+		uint64_t evicted;
+		uint64_t duplicates;
+
+		// Return the stripe of the calling thread, each thread being given the next stripe when it first calls it.
+		Stripe& stripe()
+		{
+			static std::atomic<unsigned> next(0);
+			static thread_local unsigned index = next.fetch_add(1, std::memory_order_relaxed);
+			return stripes[index % STRIPES];
+		}
+
+		uint64_t sum(std::atomic<uint64_t> Stripe::*counter) const
+		{
+			uint64_t total = 0;
+			for (const Stripe& s : stripes)
+			{
+				total += (s.*counter).load(std::memory_order_relaxed);
+			}
+			return total;
+		}
+
+		// Called with pendingMutex held.
+		void evict(std::chrono::steady_clock::time_point now)
+		{
+			while (!pendingOrder.empty()
+				&& (pending.size() > maxPending || now - pendingOrder.front().second >= pendingTimeout))
+			{
+				pending.erase(pendingOrder.front().first);
+				pendingOrder.pop_front();
+				evicted++;
+			}
+		}
+
+		void acknowledge(const std::string& closure, bool ok)
+		{
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			{
+				std::lock_guard<std::mutex> lock(pendingMutex);
+				auto it = pending.find(closure);
+				if (it != pending.end())
+				{
+					ackLatency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(now - it->second->second).count()));
+					pendingOrder.erase(it->second);
+					pending.erase(it);
+				}
+			}
+			(ok ? publishOk : publishFailed).fetch_add(1, std::memory_order_relaxed);
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataMetricsListener object.
+		 *
+		 * \param client           the client whose metrics are collected
+		 * \param listener         the listener to which the messages and the status notifications are forwarded
+		 * \param maxPending       the maximum number of published messages waiting for their publish notification
+		 * \param pendingTimeout   the time after which a publish notification is no longer waited for
+		 */
+		MigratoryDataMetricsListener(MigratoryDataClient& client, MigratoryDataListener* listener, size_t maxPending = 65536,
+			std::chrono::milliseconds pendingTimeout = std::chrono::milliseconds(60000))
+			: client(client), listener(listener), maxPending(maxPending), pendingTimeout(pendingTimeout), publishOk(0),
+			publishFailed(0), serverUp(0), serverDown(0), dataSync(0), dataResync(0), subscribeDeny(0), evicted(0),
+			duplicates(0)
+		{
+			for (Stripe& s : stripes)
+			{
+				s.messagesIn.store(0, std::memory_order_relaxed);
+				s.bytesIn.store(0, std::memory_order_relaxed);
+				for (auto& count : s.typesIn)
+				{
+					count.store(0, std::memory_order_relaxed);
+				}
+				s.messagesOut.store(0, std::memory_order_relaxed);
+				s.bytesOut.store(0, std::memory_order_relaxed);
+			}
+		}
+
+		/**
+		 * Publish a message with the client, counting it and, if it has a closure, timing its publish notification.
+		 *
+		 * \param message A MigratoryDataMessage message
+		 */
+		void publish(MigratoryDataMessage& message)
+		{
+			const std::string& closure = message.getClosureRef();
+			if (!closure.empty())
+			{
+				std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+				std::lock_guard<std::mutex> lock(pendingMutex);
+				if (pending.find(closure) != pending.end())
+				{
+					// keep timing the first message; the notifications of the two cannot be told apart
+					duplicates++;
+				}
+				else
+				{
+					pendingOrder.push_back(std::make_pair(closure, now));
+					pending.emplace(closure, std::prev(pendingOrder.end()));
+				}
+				evict(now);
+			}
+			Stripe& s = stripe();
+			s.messagesOut.fetch_add(1, std::memory_order_relaxed);
+			s.bytesOut.fetch_add(message.getSubjectRef().size() + message.getContentRef().size(), std::memory_order_relaxed);
+			client.publish(message);
+		}
+
+		/**
+		 * Count the message and forward it to the wrapped listener.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			Stripe& s = stripe();
+			s.messagesIn.fetch_add(1, std::memory_order_relaxed);
+			s.bytesIn.fetch_add(message.getSubjectRef().size() + message.getContentRef().size(), std::memory_order_relaxed);
+			int type = static_cast<int>(message.getMessageType()) - static_cast<int>(MessageType::SNAPSHOT);
+			if (type >= 0 && type < 4)
+			{
+				s.typesIn[type].fetch_add(1, std::memory_order_relaxed);
+			}
+			listener->onMessage(message);
+		}
+
+		/**
+		 * Count the status notification and forward it to the wrapped listener.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			if (status == client.NOTIFY_PUBLISH_OK)
+			{
+				acknowledge(info, true);
+			}
+			else if (status == client.NOTIFY_PUBLISH_FAILED || status == client.NOTIFY_PUBLISH_DENIED
+				|| status == client.NOTIFY_MESSAGE_SIZE_LIMIT_EXCEEDED)
+			{
+				acknowledge(info, false);
+			}
+			else if (status == client.NOTIFY_SERVER_UP)
+			{
+				serverUp.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if (status == client.NOTIFY_SERVER_DOWN)
+			{
+				serverDown.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if (status == client.NOTIFY_DATA_SYNC)
+			{
+				dataSync.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if (status == client.NOTIFY_DATA_RESYNC)
+			{
+				dataResync.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if (status == client.NOTIFY_SUBSCRIBE_DENY)
+			{
+				subscribeDeny.fetch_add(1, std::memory_order_relaxed);
+			}
+			listener->onStatus(status, info);
+		}
+
+		/**
+		 * Get a snapshot of the metrics collected so far.
+		 *
+		 * \return the current values of the metrics
+		 */
+		MigratoryDataMetricsSnapshot getMetrics()
+		{
+			MigratoryDataMetricsSnapshot metrics;
+			metrics.messagesIn = sum(&Stripe::messagesIn);
+			metrics.bytesIn = sum(&Stripe::bytesIn);
+			for (const Stripe& s : stripes)
+			{
+				metrics.snapshotsIn += s.typesIn[0].load(std::memory_order_relaxed);
+				metrics.updatesIn += s.typesIn[1].load(std::memory_order_relaxed);
+				metrics.recoveredIn += s.typesIn[2].load(std::memory_order_relaxed);
+				metrics.historicalIn += s.typesIn[3].load(std::memory_order_relaxed);
+			}
+			metrics.messagesOut = sum(&Stripe::messagesOut);
+			metrics.bytesOut = sum(&Stripe::bytesOut);
+			metrics.publishOk = publishOk.load(std::memory_order_relaxed);
+			metrics.publishFailed = publishFailed.load(std::memory_order_relaxed);
+			{
+				std::lock_guard<std::mutex> lock(pendingMutex);
+				evict(std::chrono::steady_clock::now());
+				metrics.pendingPublishes = pending.size();
+				metrics.evictedPublishes = evicted;
+				metrics.duplicateClosures = duplicates;
+			}
+			metrics.serverUp = serverUp.load(std::memory_order_relaxed);
+			metrics.serverDown = serverDown.load(std::memory_order_relaxed);
+			metrics.reconnects = metrics.serverUp > 0 ? metrics.serverUp - 1 : 0;
+			metrics.dataSync = dataSync.load(std::memory_order_relaxed);
+			metrics.dataResync = dataResync.load(std::memory_order_relaxed);
+			metrics.subscribeDeny = subscribeDeny.load(std::memory_order_relaxed);
+			metrics.ackCount = ackLatency.getCount();
+			metrics.ackLatencyMean = ackLatency.getMean();
+			metrics.ackLatencyP50 = ackLatency.getValueAtPercentile(50);
+			metrics.ackLatencyP99 = ackLatency.getValueAtPercentile(99);
+			metrics.ackLatencyMax = ackLatency.getMax();
+			return metrics;
+		}
+
+		/**
+		 * Get the histogram of the latencies of the publish notifications, expressed in microseconds.
+		 *
+		 * \return the histogram of the publish notification latencies
+		 */
+		const MigratoryDataHistogram& getAckLatency() const
+		{
+			return ackLatency;
+		}
+
+		/**
+		 * Export the current metrics in the Prometheus text exposition format.
+		 *
+		 * \param prefix the prefix of the metric names
+		 * \return the metrics, one sample per line
+		 */
+		std::string toPrometheus(const std::string& prefix = "migratorydata_client")
+		{
+			MigratoryDataMetricsSnapshot metrics = getMetrics();
+			std::ostringstream out;
+
+			auto counter = [&out, &prefix](const char* name, uint64_t value) {
+				out << "# TYPE " << prefix << "_" << name << " counter\n" << prefix << "_" << name << " " << value << "\n";
+			};
+			auto gauge = [&out, &prefix](const char* name, uint64_t value) {
+				out << "# TYPE " << prefix << "_" << name << " gauge\n" << prefix << "_" << name << " " << value << "\n";
+			};
+
+			out << "# TYPE " << prefix << "_messages_received_total counter\n";
+			out << prefix << "_messages_received_total{type=\"snapshot\"} " << metrics.snapshotsIn << "\n";
+			out << prefix << "_messages_received_total{type=\"update\"} " << metrics.updatesIn << "\n";
+			out << prefix << "_messages_received_total{type=\"recovered\"} " << metrics.recoveredIn << "\n";
+			out << prefix << "_messages_received_total{type=\"historical\"} " << metrics.historicalIn << "\n";
+			counter("bytes_received_total", metrics.bytesIn);
+			counter("messages_published_total", metrics.messagesOut);
+			counter("bytes_published_total", metrics.bytesOut);
+			counter("publish_ok_total", metrics.publishOk);
+			counter("publish_failed_total", metrics.publishFailed);
+			gauge("pending_publishes", metrics.pendingPublishes);
+			counter("evicted_publishes_total", metrics.evictedPublishes);
+			counter("duplicate_closures_total", metrics.duplicateClosures);
+			counter("server_up_total", metrics.serverUp);
+			counter("server_down_total", metrics.serverDown);
+			counter("reconnects_total", metrics.reconnects);
+			counter("data_sync_total", metrics.dataSync);
+			counter("data_resync_total", metrics.dataResync);
+			counter("subscribe_deny_total", metrics.subscribeDeny);
+
+			out << "# TYPE " << prefix << "_publish_ack_latency_microseconds summary\n";
+			out << prefix << "_publish_ack_latency_microseconds{quantile=\"0.5\"} " << metrics.ackLatencyP50 << "\n";
+			out << prefix << "_publish_ack_latency_microseconds{quantile=\"0.99\"} " << metrics.ackLatencyP99 << "\n";
+			out << prefix << "_publish_ack_latency_microseconds{quantile=\"1\"} " << metrics.ackLatencyMax << "\n";
+			out << prefix << "_publish_ack_latency_microseconds_sum " << static_cast<uint64_t>(metrics.ackLatencyMean * metrics.ackCount) << "\n";
+			out << prefix << "_publish_ack_latency_microseconds_count " << metrics.ackCount << "\n";
+
+			return out.str();
+		}
+	};
+
+}
+
+#endif // _MigratoryDataMetricsListener_h_included_
@@ -0,0 +1,692 @@
+#ifndef _MigratoryDataOutbox_h_included_
+#define _MigratoryDataOutbox_h_included_
+
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+
+#if defined (_WIN32)
+#if !defined (WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#endif
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * A listener which keeps the messages published with QoS::GUARANTEED in an append-only file until they are
+	 * acknowledged, so that they survive server outages as well as restarts of the application.
+	 *
+	 * Each message published through \link publish() \endlink with QoS::GUARANTEED is appended to the outbox file
+	 * before being handed to the client. While no server is up, it is only appended. Every time the client
+	 * notifies \link MigratoryDataClient.NOTIFY_SERVER_UP \endlink, the messages of the outbox are published again in
+	 * the order they were first published, which includes the messages recovered from the file when the outbox was
+	 * opened. A message leaves the outbox when it gets \link MigratoryDataClient.NOTIFY_PUBLISH_OK \endlink, or a
+	 * notification which retrying cannot fix (\link MigratoryDataClient.NOTIFY_PUBLISH_DENIED \endlink or
+	 * \link MigratoryDataClient.NOTIFY_MESSAGE_SIZE_LIMIT_EXCEEDED \endlink); on
+	 * \link MigratoryDataClient.NOTIFY_PUBLISH_FAILED \endlink it stays in the outbox and is published again every
+	 * \c retryInterval while a server is up, after the messages published meanwhile. Messages are therefore
+	 * delivered at least once, and subscribers should be ready to filter duplicates.
+	 *
+	 * While the outbox is being published again after \link MigratoryDataClient.NOTIFY_SERVER_UP \endlink, the new
+	 * messages are queued behind it, so they cannot overtake the older ones. The outbox assumes that no server is up
+	 * when it is created; when it is created while a server is already up, say so to the constructor, and the
+	 * messages recovered from the file are then published after \c retryInterval.
+	 *
+	 * Messages are matched to their notifications by closure, so the closures given by the application must be
+	 * unique; messages without closure are given one, whose notifications are not forwarded to the wrapped listener.
+	 *
+	 * The file is made of length-prefixed, checksummed records: one per published message, and one per message
+	 * leaving the outbox. When appending a record would make the file exceed its maximum size, the file is first
+	 * compacted to the messages still in the outbox; if it is still too large, the message is refused. A record
+	 * truncated by a crash is detected by its checksum and discarded when the outbox is opened. Compaction writes a
+	 * temporary file next to the outbox file and renames it over the outbox file, which replaces it atomically, so a
+	 * crash leaves either the old or the new file. Records are flushed to the operating system after each append, so
+	 * they survive a crash of the application but not of the machine.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the wrapped listener.
+	 */
+	class MigratoryDataOutbox : public MigratoryDataListener
+	{
+
+	private :
+
+		enum
+		{
+			RECORD_HEADER = 8,
+			RECORD_PUBLISH = 'P',
+			RECORD_REMOVE = 'R'
+		};
+
+		struct Entry
+		{
+			std::string subject;
+			std::string content;
+			std::string closure;
+			std::string replySubject;
+			bool retained;
+			bool compressed;
+			bool assigned;
+			// true after NOTIFY_PUBLISH_FAILED, until the message is published again; not kept in the file
+			bool failed;
+		};
+
+		MigratoryDataClient& client;
+		MigratoryDataListener* listener;
+		std::string path;
+		uint64_t maxSize;
+		std::chrono::milliseconds retryInterval;
+
+		std::mutex mutex;
+		std::FILE* file;
+		uint64_t size;
+		uint64_t lastId;
+		// true once the outbox was published again after NOTIFY_SERVER_UP, until NOTIFY_SERVER_DOWN
+		bool connected;
+		// true while the outbox is to be published again, during which publish() only queues
+		bool replaying;
+		std::map<uint64_t, Entry> pending;
+		std::unordered_map<std::string, uint64_t> ids;
+		std::vector<uint8_t> buffer;
+
+		// held by the thread publishing the outbox again, so that replays and retries do not interleave
+		std::mutex replayMutex;
+		std::condition_variable wakeUp;
+		bool stopped;
+		std::thread retrier;
+
+		// Prefix of the closures assigned by the outbox; a control character keeps them apart from the
+		// closures given by the application.
+		static const char* assignedPrefix()
+		{
+			return "\x02outbox-";
+		}
+
+		static uint32_t checksum(const uint8_t* data, size_t length)
+		{
+			uint32_t hash = 2166136261u;
+			for (size_t i = 0; i < length; i++)
+			{
+				hash = (hash ^ data[i]) * 16777619u;
+			}
+			return hash;
+		}
+
+		static void put32(std::vector<uint8_t>& out, uint32_t value)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+			}
+		}
+
+		static void put64(std::vector<uint8_t>& out, uint64_t value)
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+			}
+		}
+
+		static void putString(std::vector<uint8_t>& out, const std::string& value)
+		{
+			put32(out, static_cast<uint32_t>(value.size()));
+			out.insert(out.end(), value.begin(), value.end());
+		}
+
+		static uint32_t get32(const uint8_t* data)
+		{
+			uint32_t value = 0;
+			for (int i = 3; i >= 0; i--)
+			{
+				value = (value << 8) | data[i];
+			}
+			return value;
+		}
+
+		static uint64_t get64(const uint8_t* data)
+		{
+			uint64_t value = 0;
+			for (int i = 7; i >= 0; i--)
+			{
+				value = (value << 8) | data[i];
+			}
+			return value;
+		}
+
+		static bool getString(const uint8_t*& data, const uint8_t* end, std::string& value)
+		{
+			if (end - data < 4)
+			{
+				return false;
+			}
+			uint32_t length = get32(data);
+			data += 4;
+			if (static_cast<uint64_t>(end - data) < length)
+			{
+				return false;
+			}
+			value.assign(reinterpret_cast<const char*>(data), length);
+			data += length;
+			return true;
+		}
+
+		static void encodePublish(std::vector<uint8_t>& out, uint64_t id, const Entry& entry)
+		{
+			out.push_back(static_cast<uint8_t>(RECORD_PUBLISH));
+			put64(out, id);
+			out.push_back(static_cast<uint8_t>((entry.retained ? 1 : 0) | (entry.compressed ? 2 : 0) | (entry.assigned ? 4 : 0)));
+			putString(out, entry.subject);
+			putString(out, entry.content);
+			putString(out, entry.closure);
+			putString(out, entry.replySubject);
+		}
+
+		static void encodeRemove(std::vector<uint8_t>& out, uint64_t id)
+		{
+			out.push_back(static_cast<uint8_t>(RECORD_REMOVE));
+			put64(out, id);
+		}
+
+		// Append the record whose body is in buffer, prefixed by its length and checksum, adding its size to written.
+		bool append(std::FILE* out, size_t& written)
+		{
+			uint8_t header[RECORD_HEADER];
+			uint32_t length = static_cast<uint32_t>(buffer.size());
+			uint32_t sum = checksum(buffer.data(), buffer.size());
+			for (int i = 0; i < 4; i++)
+			{
+				header[i] = static_cast<uint8_t>(length >> (8 * i));
+				header[4 + i] = static_cast<uint8_t>(sum >> (8 * i));
+			}
+			if (std::fwrite(header, 1, RECORD_HEADER, out) != RECORD_HEADER
+				|| std::fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size())
+			{
+				return false;
+			}
+			written += RECORD_HEADER + buffer.size();
+			return true;
+		}
+
+		// Apply a record read from the file; return false if it removes a message or repeats the closure of a
+		// message still in the outbox, which is dropped.
+		bool apply(const uint8_t* data, const uint8_t* end)
+		{
+			uint8_t type = *data++;
+			if (end - data < 8)
+			{
+				return true;
+			}
+			uint64_t id = get64(data);
+			data += 8;
+			if (id > lastId)
+			{
+				lastId = id;
+			}
+
+			if (type == RECORD_REMOVE)
+			{
+				auto it = pending.find(id);
+				if (it != pending.end())
+				{
+					ids.erase(it->second.closure);
+					pending.erase(it);
+				}
+				return false;
+			}
+			else if (type == RECORD_PUBLISH && data < end)
+			{
+				Entry entry;
+				uint8_t flags = *data++;
+				entry.retained = (flags & 1) != 0;
+				entry.compressed = (flags & 2) != 0;
+				entry.assigned = (flags & 4) != 0;
+				entry.failed = false;
+				if (getString(data, end, entry.subject) && getString(data, end, entry.content)
+					&& getString(data, end, entry.closure) && getString(data, end, entry.replySubject))
+				{
+					if (!ids.emplace(entry.closure, id).second)
+					{
+						return false;
+					}
+					pending[id] = std::move(entry);
+				}
+			}
+			return true;
+		}
+
+		// Replace a file by another one atomically.
+		static bool replace(const std::string& from, const std::string& to)
+		{
+#if defined (_WIN32)
+			return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+			return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+		}
+
+		// Apply the records of the file up to the first missing or corrupted one. The file is rewritten with
+		// the messages still in the outbox only if it holds removed messages or ends with a corrupted record;
+		// otherwise it is simply reopened for appending. Without a file, the temporary file of a compaction
+		// interrupted before the replacement, if any, is recovered instead and becomes the file.
+		void recover()
+		{
+			bool clean = true;
+			std::FILE* in = std::fopen(path.c_str(), "rb");
+			if (in == nullptr)
+			{
+				in = std::fopen((path + ".tmp").c_str(), "rb");
+				clean = in == nullptr;
+			}
+			if (in != nullptr)
+			{
+				std::setvbuf(in, nullptr, _IOFBF, 1 << 20);
+				uint8_t header[RECORD_HEADER];
+				size_t read;
+				while ((read = std::fread(header, 1, RECORD_HEADER, in)) == RECORD_HEADER)
+				{
+					uint32_t length = get32(header);
+					buffer.resize(length);
+					if (length == 0 || length > maxSize || std::fread(buffer.data(), 1, length, in) != length
+						|| checksum(buffer.data(), length) != get32(header + 4))
+					{
+						clean = false;
+						break;
+					}
+					size += RECORD_HEADER + length;
+					clean = apply(buffer.data(), buffer.data() + length) && clean;
+				}
+				clean = clean && read == 0;
+				std::fclose(in);
+			}
+
+			if (clean)
+			{
+				file = std::fopen(path.c_str(), "ab");
+			}
+			else
+			{
+				compact();
+			}
+		}
+
+		// Rewrite the file with the messages still in the outbox only; the size of the file is updated only once the
+		// rewritten file has replaced it.
+		bool compact()
+		{
+			if (file != nullptr)
+			{
+				std::fclose(file);
+				file = nullptr;
+			}
+
+			std::string temporary = path + ".tmp";
+			std::FILE* out = std::fopen(temporary.c_str(), "wb");
+			bool ok = out != nullptr;
+			size_t written = 0;
+			for (auto it = pending.begin(); ok && it != pending.end(); ++it)
+			{
+				buffer.clear();
+				encodePublish(buffer, it->first, it->second);
+				ok = append(out, written);
+			}
+			if (out != nullptr)
+			{
+				ok = std::fclose(out) == 0 && ok;
+			}
+			if (ok)
+			{
+				ok = replace(temporary, path);
+			}
+			if (ok)
+			{
+				size = written;
+			}
+
+			file = std::fopen(path.c_str(), "ab");
+			return ok && file != nullptr;
+		}
+
+		// Append the record whose body is in buffer to the file, compacting it first if needed.
+		bool write()
+		{
+			if (size + RECORD_HEADER + buffer.size() > maxSize)
+			{
+				std::vector<uint8_t> record;
+				record.swap(buffer);
+				compact();
+				record.swap(buffer);
+				if (size + RECORD_HEADER + buffer.size() > maxSize)
+				{
+					return false;
+				}
+			}
+			return file != nullptr && append(file, size) && std::fflush(file) == 0;
+		}
+
+		static MigratoryDataMessage toMessage(const Entry& entry)
+		{
+			MigratoryDataMessage message(entry.subject, entry.content, entry.closure, QoS::GUARANTEED, entry.retained, entry.replySubject);
+			message.setCompressed(entry.compressed);
+			return message;
+		}
+
+		// Publish the whole outbox again, in order, then the messages queued meanwhile, until none is left; called
+		// with replayMutex held.
+		void replay()
+		{
+			uint64_t from = 0;
+			for (;;)
+			{
+				std::vector<MigratoryDataMessage> batch;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (!replaying)
+					{
+						// the server went down meanwhile
+						return;
+					}
+					for (auto it = pending.upper_bound(from); it != pending.end(); ++it)
+					{
+						it->second.failed = false;
+						batch.push_back(toMessage(it->second));
+					}
+					if (batch.empty())
+					{
+						replaying = false;
+						connected = true;
+						return;
+					}
+					from = pending.rbegin()->first;
+				}
+				for (auto& message : batch)
+				{
+					client.publish(message);
+				}
+			}
+		}
+
+		// Publish again the messages which got NOTIFY_PUBLISH_FAILED; called with replayMutex held.
+		void retry()
+		{
+			std::vector<MigratoryDataMessage> batch;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!connected)
+				{
+					return;
+				}
+				for (auto& it : pending)
+				{
+					if (it.second.failed)
+					{
+						it.second.failed = false;
+						batch.push_back(toMessage(it.second));
+					}
+				}
+			}
+			for (auto& message : batch)
+			{
+				client.publish(message);
+			}
+		}
+
+		void run()
+		{
+			std::unique_lock<std::mutex> lock(replayMutex);
+			while (!stopped)
+			{
+				wakeUp.wait_for(lock, retryInterval);
+				if (stopped)
+				{
+					return;
+				}
+				bool recovering;
+				{
+					std::lock_guard<std::mutex> state(mutex);
+					recovering = replaying;
+				}
+				if (recovering)
+				{
+					replay();
+				}
+				else
+				{
+					retry();
+				}
+			}
+		}
+
+		// Remove the message matching the closure, if any; return true if its closure was assigned by the outbox.
+		bool remove(const std::string& closure)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			auto id = ids.find(closure);
+			if (id == ids.end())
+			{
+				return false;
+			}
+			auto it = pending.find(id->second);
+			bool assigned = it->second.assigned;
+			buffer.clear();
+			encodeRemove(buffer, id->second);
+			pending.erase(it);
+			ids.erase(id);
+			write();
+			return assigned;
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataOutbox object, recovering the messages left in the outbox file by a previous run.
+		 *
+		 * \param client          the client used to publish the messages
+		 * \param listener        the listener to which the messages and the status notifications are forwarded
+		 * \param path            the path of the outbox file; it is created if it does not exist
+		 * \param maxSize         the maximum size of the outbox file, in bytes
+		 * \param serverUp        whether a server is already up, in which case the recovered messages are published
+		 *                        after \c retryInterval instead of on the next
+		 *                        \link MigratoryDataClient.NOTIFY_SERVER_UP \endlink
+		 * \param retryInterval   the interval at which the messages which got
+		 *                        \link MigratoryDataClient.NOTIFY_PUBLISH_FAILED \endlink are published again
+		 */
+		MigratoryDataOutbox(MigratoryDataClient& client, MigratoryDataListener* listener, const std::string& path, uint64_t maxSize,
+			bool serverUp = false, std::chrono::milliseconds retryInterval = std::chrono::milliseconds(5000))
+			: client(client), listener(listener), path(path), maxSize(maxSize), retryInterval(retryInterval), file(nullptr),
+			size(0), lastId(0), connected(false), replaying(serverUp), stopped(false)
+		{
+			recover();
+			retrier = std::thread([this] { run(); });
+		}
+
+		MigratoryDataOutbox(const MigratoryDataOutbox&) = delete;
+		MigratoryDataOutbox& operator=(const MigratoryDataOutbox&) = delete;
+
+		/**
+		 * Publish a message, keeping it in the outbox until it is acknowledged if its QoS is QoS::GUARANTEED.
+		 *
+		 * Messages with QoS::STANDARD are handed to the client directly.
+		 *
+		 * \param message A MigratoryDataMessage message
+		 * \return \c true if the message was published or queued in the outbox; \c false if the outbox file is full
+		 *         or cannot be written, or if a message with the same closure is still in the outbox, in which case
+		 *         \link MigratoryDataClient.NOTIFY_PUBLISH_FAILED \endlink is also notified for the closure of the
+		 *         message, if any
+		 */
+		bool publish(MigratoryDataMessage& message)
+		{
+			if (message.getQos() != QoS::GUARANTEED)
+			{
+				client.publish(message);
+				return true;
+			}
+
+			Entry entry;
+			entry.subject = message.getSubject();
+			entry.content = message.getContent();
+			entry.closure = message.getClosure();
+			entry.replySubject = message.getReplySubject();
+			entry.retained = message.isRetained();
+			entry.compressed = message.isCompressed();
+			entry.assigned = entry.closure.empty();
+			entry.failed = false;
+
+			std::unique_lock<std::mutex> lock(mutex);
+			if (!entry.assigned && ids.count(entry.closure) != 0)
+			{
+				// the pending message with the same closure could no longer be told apart from this one
+				lock.unlock();
+				listener->onStatus(client.NOTIFY_PUBLISH_FAILED, entry.closure);
+				return false;
+			}
+			uint64_t id = ++lastId;
+			if (entry.assigned)
+			{
+				entry.closure = assignedPrefix() + std::to_string(id);
+			}
+
+			buffer.clear();
+			encodePublish(buffer, id, entry);
+			if (!write())
+			{
+				lock.unlock();
+				if (!entry.assigned)
+				{
+					listener->onStatus(client.NOTIFY_PUBLISH_FAILED, entry.closure);
+				}
+				return false;
+			}
+			ids[entry.closure] = id;
+			if (!connected)
+			{
+				pending[id] = std::move(entry);
+				return true;
+			}
+			MigratoryDataMessage tracked = toMessage(entry);
+			pending[id] = std::move(entry);
+			lock.unlock();
+
+			client.publish(tracked);
+			return true;
+		}
+
+		/**
+		 * Forward the message to the wrapped listener.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			listener->onMessage(message);
+		}
+
+		/**
+		 * Track the connection and the publish notifications, then forward the notification to the wrapped listener
+		 * unless it concerns a closure assigned by the outbox.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			if (status == client.NOTIFY_SERVER_UP)
+			{
+				std::lock_guard<std::mutex> replayLock(replayMutex);
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					connected = false;
+					replaying = true;
+				}
+				replay();
+			}
+			else if (status == client.NOTIFY_SERVER_DOWN)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				connected = false;
+				replaying = false;
+			}
+			else if (status == client.NOTIFY_PUBLISH_OK || status == client.NOTIFY_PUBLISH_DENIED
+				|| status == client.NOTIFY_MESSAGE_SIZE_LIMIT_EXCEEDED)
+			{
+				if (remove(info))
+				{
+					return;
+				}
+			}
+			else if (status == client.NOTIFY_PUBLISH_FAILED)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto id = ids.find(info);
+				if (id != ids.end())
+				{
+					Entry& entry = pending[id->second];
+					entry.failed = true;
+					if (entry.assigned)
+					{
+						return;
+					}
+				}
+			}
+			listener->onStatus(status, info);
+		}
+
+		/**
+		 * Get the number of messages waiting in the outbox for their acknowledgement.
+		 *
+		 * \return the number of messages in the outbox
+		 */
+		size_t getPending()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return pending.size();
+		}
+
+		/**
+		 * Get the current size of the outbox file.
+		 *
+		 * \return the size of the outbox file, in bytes
+		 */
+		uint64_t getFileSize()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return size;
+		}
+
+		/**
+		 * \brief Destructor.
+		 *
+		 * Stop the retries and close the outbox file; the messages still in the outbox are recovered the next time it is
+		 * opened.
+		 */
+		virtual ~MigratoryDataOutbox()
+		{
+			{
+				std::lock_guard<std::mutex> lock(replayMutex);
+				stopped = true;
+				wakeUp.notify_all();
+			}
+			retrier.join();
+			if (file != nullptr)
+			{
+				std::fclose(file);
+			}
+		}
+	};
+
+}
+
+#endif // _MigratoryDataOutbox_h_included_
@@ -0,0 +1,157 @@
+#ifndef _MigratoryDataPollListener_h_included_
+#define _MigratoryDataPollListener_h_included_
+
+#include "MigratoryDataListener.h"
+#include "MigratoryDataDispatchPolicy.h"
+#include "MigratoryDataRingBuffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * A listener which queues the received messages and status notifications into bounded lock-free rings, so that
+	 * the application can drain them in batches from its own thread with \link poll() \endlink and
+	 * \link pollStatus() \endlink, instead of handling them in callbacks on the thread of the library.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink. Any number of threads may poll
+	 * concurrently, although draining from a single thread preserves the order of the messages.
+	 */
+	class MigratoryDataPollListener : public MigratoryDataListener
+	{
+
+	private :
+
+		MigratoryDataRingBuffer<MigratoryDataMessage> messages;
+		MigratoryDataRingBuffer<std::pair<std::string, std::string>> statuses;
+		DispatchPolicy policy;
+		std::atomic<unsigned long long> dropped;
+
+	public :
+
+		/**
+		 * Create a MigratoryDataPollListener object.
+		 *
+		 * \param capacity         the minimum number of messages which can wait to be polled
+		 * \param statusCapacity   the minimum number of status notifications which can wait to be polled; when full,
+		 *                         new status notifications are dropped
+		 * \param policy           the policy applied when the ring of messages is full; with DispatchPolicy::BLOCK
+		 *                         the thread of the library yields until the application polls
+		 */
+		MigratoryDataPollListener(size_t capacity, size_t statusCapacity, DispatchPolicy policy)
+			: messages(capacity), statuses(statusCapacity), policy(policy), dropped(0)
+		{
+		}
+
+		/**
+		 * Queue the message to be polled.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			MigratoryDataMessage copy(message);
+			while (!messages.tryPush(std::move(copy)))
+			{
+				switch (policy)
+				{
+				case DispatchPolicy::BLOCK:
+					std::this_thread::yield();
+					break;
+				case DispatchPolicy::DROP_NEWEST:
+					dropped.fetch_add(1, std::memory_order_relaxed);
+					return;
+				case DispatchPolicy::DROP_OLDEST:
+					{
+						MigratoryDataMessage oldest;
+						if (messages.tryPop(oldest))
+						{
+							dropped.fetch_add(1, std::memory_order_relaxed);
+						}
+					}
+					break;
+				}
+			}
+		}
+
+		/**
+		 * Queue the status notification to be polled.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			statuses.tryPush(std::make_pair(status, info));
+		}
+
+		/**
+		 * Move up to \c max queued messages to the end of \c out, in the order they were received.
+		 *
+		 * Reserve the capacity of \c out in advance to avoid reallocations while draining.
+		 *
+		 * \param out   the vector to which the messages are appended
+		 * \param max   the maximum number of messages to be appended
+		 * \return the number of messages appended
+		 */
+		size_t poll(std::vector<MigratoryDataMessage>& out, size_t max)
+		{
+			size_t count = 0;
+			MigratoryDataMessage message;
+			while (count < max && messages.tryPop(message))
+			{
+				out.push_back(std::move(message));
+				count++;
+			}
+			return count;
+		}
+
+		/**
+		 * Move up to \c max queued status notifications to the end of \c out, as (status, info) pairs.
+		 *
+		 * \param out   the vector to which the status notifications are appended
+		 * \param max   the maximum number of status notifications to be appended
+		 * \return the number of status notifications appended
+		 */
+		size_t pollStatus(std::vector<std::pair<std::string, std::string>>& out, size_t max)
+		{
+			size_t count = 0;
+			std::pair<std::string, std::string> status;
+			while (count < max && statuses.tryPop(status))
+			{
+				out.push_back(std::move(status));
+				count++;
+			}
+			return count;
+		}
+
+		/**
+		 * Get the number of messages waiting to be polled.
+		 *
+		 * \return the number of queued messages
+		 */
+		size_t getQueueDepth() const
+		{
+			return messages.size();
+		}
+
+		/**
+		 * Get the number of messages dropped because the ring was full.
+		 *
+		 * \return the number of dropped messages; always \c 0 with DispatchPolicy::BLOCK
+		 */
+		unsigned long long getDroppedMessages() const
+		{
+			return dropped.load(std::memory_order_relaxed);
+		}
+	};
+
+}
+
+#endif // _MigratoryDataPollListener_h_included_
@@ -0,0 +1,353 @@
+#ifndef _MigratoryDataPublishWindow_h_included_
+#define _MigratoryDataPublishWindow_h_included_
+
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * The policy applied by a \link MigratoryDataPublishWindow \endlink when a message is published while the window
+	 * is full.
+	 */
+	enum class WindowPolicy {
+
+		/**
+		 * Wait until a publish notification frees a slot of the window, or until the blocking timeout expires, in
+		 * which case the message is failed as with WindowPolicy::FAIL.
+		 *
+		 * Publishing with this policy from a callback of the library, such as
+		 * \link MigratoryDataListener.onMessage() \endlink, stalls the thread of the library running the callback
+		 * while the window is full; when that thread is also the one delivering the publish notifications, the window
+		 * cannot drain meanwhile and each such publication waits for the whole blocking timeout.
+		 */
+		BLOCK,
+
+		/**
+		 * Drop the message silently.
+		 */
+		DROP,
+
+		/**
+		 * Drop the message and, if it has a closure, notify \link MigratoryDataClient.NOTIFY_PUBLISH_FAILED \endlink
+		 * for it to the wrapped listener.
+		 */
+		FAIL
+
+	};
+
+	/**
+	 * A listener which bounds the number of published messages waiting for their publish notification.
+	 *
+	 * Messages published through \link publish() \endlink are handed to the client right away as long as fewer than
+	 * \c window messages are in flight, so publishing is pipelined up to the window instead of waiting for each
+	 * notification. A message in flight is released by its \link MigratoryDataClient.NOTIFY_PUBLISH_OK \endlink,
+	 * \link MigratoryDataClient.NOTIFY_PUBLISH_FAILED \endlink, \link MigratoryDataClient.NOTIFY_PUBLISH_DENIED \endlink
+	 * or \link MigratoryDataClient.NOTIFY_MESSAGE_SIZE_LIMIT_EXCEEDED \endlink notification, at which point the
+	 * round-trip time of the message is reported to the optional acknowledgement callback.
+	 *
+	 * Messages published without a closure are given a closure made of a sequence number, so that their notification
+	 * can be tracked; these notifications are consumed by the window and not forwarded to the wrapped listener. The
+	 * closures given by the application must be unique among the messages in flight.
+	 *
+	 * A message whose notification does not arrive within \c ackTimeout, for instance because it was lost with the
+	 * connection, is expired: its slot is freed, and it is reported as
+	 * \link MigratoryDataClient.NOTIFY_PUBLISH_FAILED \endlink to the acknowledgement callback and, if it has a closure
+	 * given by the application, to the wrapped listener. A notification arriving after the expiry of its message is
+	 * forwarded as is, unless the closure was assigned by the window. The messages in flight are expired when a
+	 * message is published and while waiting for a free slot.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the wrapped listener.
+	 */
+	class MigratoryDataPublishWindow : public MigratoryDataListener
+	{
+
+	public :
+
+		/**
+		 * The function called when a message in flight gets its publish notification.
+		 *
+		 * The arguments are the closure of the message (empty if the closure was assigned by the window), the status
+		 * notification, and the time elapsed between the publication of the message and its notification.
+		 */
+		typedef std::function<void(const std::string& closure, const std::string& status, std::chrono::microseconds rtt)> AckCallback;
+
+	private :
+
+		struct InFlight
+		{
+			std::string closure;
+			std::chrono::steady_clock::time_point sent;
+			bool assigned;
+		};
+
+		typedef std::list<InFlight> InFlightList;
+
+		MigratoryDataClient& client;
+		MigratoryDataListener* listener;
+		size_t window;
+		WindowPolicy policy;
+		std::chrono::milliseconds blockTimeout;
+		AckCallback ackCallback;
+		std::chrono::milliseconds ackTimeout;
+
+		std::mutex mutex;
+		std::condition_variable notFull;
+		// the messages in flight, oldest first, and their index by closure
+		InFlightList order;
+		std::unordered_map<std::string, InFlightList::iterator> inFlight;
+		uint64_t sequence;
+		uint64_t dropped;
+		uint64_t expired;
+
+		// Prefix of the closures assigned by the window; a control character keeps them apart from the
+		// closures given by the application.
+		static const char* assignedPrefix()
+		{
+			return "\x01window-";
+		}
+
+		// Called with the mutex held; move the messages in flight past their deadline to `late`.
+		void expire(std::chrono::steady_clock::time_point now, std::vector<InFlight>& late)
+		{
+			while (!order.empty() && now - order.front().sent >= ackTimeout)
+			{
+				inFlight.erase(order.front().closure);
+				late.push_back(std::move(order.front()));
+				order.pop_front();
+				expired++;
+			}
+		}
+
+		// Called without the mutex held; report the expired messages as failed.
+		void fail(const std::vector<InFlight>& late)
+		{
+			if (late.empty())
+			{
+				return;
+			}
+			notFull.notify_all();
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			for (const InFlight& entry : late)
+			{
+				if (ackCallback)
+				{
+					ackCallback(entry.assigned ? std::string() : entry.closure, client.NOTIFY_PUBLISH_FAILED,
+						std::chrono::duration_cast<std::chrono::microseconds>(now - entry.sent));
+				}
+				if (!entry.assigned)
+				{
+					std::string closure = entry.closure;
+					listener->onStatus(client.NOTIFY_PUBLISH_FAILED, closure);
+				}
+			}
+		}
+
+		bool release(const std::string& status, std::string& info)
+		{
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			InFlight entry;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = inFlight.find(info);
+				if (it == inFlight.end())
+				{
+					// the late notification of an expired message whose closure was assigned by the window
+					return info.compare(0, std::char_traits<char>::length(assignedPrefix()), assignedPrefix()) == 0;
+				}
+				entry = std::move(*it->second);
+				order.erase(it->second);
+				inFlight.erase(it);
+			}
+			notFull.notify_one();
+
+			if (ackCallback)
+			{
+				ackCallback(entry.assigned ? std::string() : info, status,
+					std::chrono::duration_cast<std::chrono::microseconds>(now - entry.sent));
+			}
+			return entry.assigned;
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataPublishWindow object.
+		 *
+		 * \param client         the client used to publish the messages
+		 * \param listener       the listener to which the messages and the status notifications are forwarded
+		 * \param window         the maximum number of messages in flight; at least one
+		 * \param policy         the policy applied when a message is published while the window is full
+		 * \param blockTimeout   the maximum time to wait for a free slot with WindowPolicy::BLOCK
+		 * \param ackCallback    the function called with the round-trip time of each message (OPTIONAL)
+		 * \param ackTimeout     the time after which a message still waiting for its publish notification is expired
+		 */
+		MigratoryDataPublishWindow(MigratoryDataClient& client, MigratoryDataListener* listener, size_t window,
+			WindowPolicy policy, std::chrono::milliseconds blockTimeout, AckCallback ackCallback = AckCallback(),
+			std::chrono::milliseconds ackTimeout = std::chrono::milliseconds(30000))
+			: client(client), listener(listener), window(window > 0 ? window : 1), policy(policy),
+			blockTimeout(blockTimeout), ackCallback(ackCallback), ackTimeout(ackTimeout), sequence(0), dropped(0),
+			expired(0)
+		{
+		}
+
+		/**
+		 * Publish a message if the window has a free slot, applying the window policy otherwise.
+		 *
+		 * \param message A MigratoryDataMessage message
+		 * \return \c true if the message was handed to the client; \c false if it was dropped or failed, which is
+		 *         also the case when a message with the same closure is still in flight
+		 */
+		bool publish(MigratoryDataMessage& message)
+		{
+			std::string closure = message.getClosure();
+			bool assigned = closure.empty();
+
+			std::vector<InFlight> late;
+			std::unique_lock<std::mutex> lock(mutex);
+			if (assigned)
+			{
+				closure = assignedPrefix() + std::to_string(++sequence);
+			}
+
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+			expire(now, late);
+			bool available = inFlight.size() < window;
+			if (!available && policy == WindowPolicy::BLOCK)
+			{
+				// wake up at the deadline of the oldest message in flight too, to expire it
+				std::chrono::steady_clock::time_point deadline = now + blockTimeout;
+				while (!available && now < deadline)
+				{
+					std::chrono::steady_clock::time_point until = order.empty() || order.front().sent + ackTimeout > deadline
+						? deadline : order.front().sent + ackTimeout;
+					notFull.wait_until(lock, until);
+					now = std::chrono::steady_clock::now();
+					expire(now, late);
+					available = inFlight.size() < window;
+				}
+			}
+			if (!available)
+			{
+				dropped++;
+				lock.unlock();
+				fail(late);
+				if (policy != WindowPolicy::DROP && !assigned)
+				{
+					listener->onStatus(client.NOTIFY_PUBLISH_FAILED, closure);
+				}
+				return false;
+			}
+
+			auto inserted = inFlight.emplace(closure, order.end());
+			if (!inserted.second)
+			{
+				// a message with the same closure is still in flight and its notification could not be told apart
+				lock.unlock();
+				fail(late);
+				listener->onStatus(client.NOTIFY_PUBLISH_FAILED, closure);
+				return false;
+			}
+			InFlight entry;
+			entry.closure = closure;
+			entry.sent = std::chrono::steady_clock::now();
+			entry.assigned = assigned;
+			order.push_back(entry);
+			inserted.first->second = std::prev(order.end());
+			lock.unlock();
+			fail(late);
+
+			if (assigned)
+			{
+				MigratoryDataMessage tracked(message.getSubjectRef(), message.getContentRef(), closure, message.getQos(),
+					message.isRetained(), message.getReplySubjectRef());
+				tracked.setCompressed(message.isCompressed());
+				client.publish(tracked);
+			}
+			else
+			{
+				client.publish(message);
+			}
+			return true;
+		}
+
+		/**
+		 * Forward the message to the wrapped listener.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			listener->onMessage(message);
+		}
+
+		/**
+		 * Release the message in flight matching a publish notification, then forward the notification to the
+		 * wrapped listener unless it concerns a closure assigned by the window.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			if (status == client.NOTIFY_PUBLISH_OK || status == client.NOTIFY_PUBLISH_FAILED
+				|| status == client.NOTIFY_PUBLISH_DENIED || status == client.NOTIFY_MESSAGE_SIZE_LIMIT_EXCEEDED)
+			{
+				if (release(status, info))
+				{
+					return;
+				}
+			}
+			listener->onStatus(status, info);
+		}
+
+		/**
+		 * Get the number of messages waiting for their publish notification.
+		 *
+		 * \return the number of messages in flight
+		 */
+		size_t getInFlight()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return inFlight.size();
+		}
+
+		/**
+		 * Get the number of messages expired because their publish notification did not arrive in time.
+		 *
+		 * \return the number of expired messages
+		 */
+		uint64_t getExpiredMessages()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return expired;
+		}
+
+		/**
+		 * Get the number of messages dropped or failed because the window was full.
+		 *
+		 * \return the number of messages not published
+		 */
+		uint64_t getDroppedMessages()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return dropped;
+		}
+	};
+
+}
+
+#endif // _MigratoryDataPublishWindow_h_included_
@@ -0,0 +1,670 @@
+#ifndef _MigratoryDataRequester_h_included_
+#define _MigratoryDataRequester_h_included_
+
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+#include "MigratoryDataTimerWheel.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * The outcome of a request made with \link MigratoryDataRequester \endlink.
+	 */
+	enum class ReplyStatus {
+
+		/**
+		 * A reply was received.
+		 */
+		REPLIED,
+
+		/**
+		 * No reply was received before the timeout of the request.
+		 */
+		TIMED_OUT,
+
+		/**
+		 * The request could not be published, as notified by \link MigratoryDataClient.NOTIFY_PUBLISH_FAILED \endlink,
+		 * \link MigratoryDataClient.NOTIFY_PUBLISH_DENIED \endlink or
+		 * \link MigratoryDataClient.NOTIFY_MESSAGE_SIZE_LIMIT_EXCEEDED \endlink.
+		 */
+		PUBLISH_FAILED,
+
+		/**
+		 * The maximum number of requests in flight was reached, so the request was not published.
+		 */
+		REJECTED,
+
+		/**
+		 * The subscription to the reply subject of the request was denied, as notified by
+		 * \link MigratoryDataClient.NOTIFY_SUBSCRIBE_DENY \endlink, so the request was not published.
+		 */
+		SUBSCRIBE_DENIED
+
+	};
+
+	/**
+	 * A listener which correlates the replies with their requests, on top of the reply subject of the messages.
+	 *
+	 * Each request in flight is given a reply subject of its own, taken from a pool of subjects made of the inbox of
+	 * the requester followed by the index of the subject, such as \c /inbox/client-1/17. The subjects of the pool are
+	 * subscribed once, and reused by the next requests, so a reply is matched to its request by the index in its
+	 * subject, in constant time and without a subscription per request. The pool doubles in size each time it runs
+	 * out of subjects, up to \c maxInFlight, and the subjects added are subscribed in a single call; use
+	 * \link reserve() \endlink to subscribe them before the first requests. The timeouts are run on a
+	 * \link MigratoryDataTimerWheel \endlink by a background thread, so any number of requests can be in flight
+	 * without a thread waiting for each of them.
+	 *
+	 * A request given a reply subject whose subscription is not allowed yet is held until
+	 * \link MigratoryDataClient.NOTIFY_SUBSCRIBE_ALLOW \endlink, so that its reply cannot arrive before the
+	 * subscription; if the subscription is denied, the request completes with ReplyStatus::SUBSCRIBE_DENIED, the subject
+	 * is no longer used, and the notification \link MigratoryDataClient.NOTIFY_SUBSCRIBE_DENY \endlink is forwarded.
+	 *
+	 * A request completes with its first reply. The subject of a request which timed out or could not be published is
+	 * kept out of use during \c quarantine, so that a late reply is dropped rather than taken for the reply of a later
+	 * request; a late reply arriving after the quarantine, or a reply sent more than once, cannot be told apart from
+	 * the reply of the next request using the subject. The subject of a replied request is reused after all the other
+	 * free subjects. The closure of a request message is replaced by a closure of the requester, whose publish
+	 * notifications are consumed. The completion callbacks run on the thread of the library or, for the timeouts, on
+	 * the thread of the requester, so they must not block.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the wrapped listener,
+	 * and destroy it only after \link MigratoryDataClient.disconnect() \endlink.
+	 */
+	class MigratoryDataRequester : public MigratoryDataListener
+	{
+
+	public :
+
+		/**
+		 * The function called when a request completes, with its outcome and, for ReplyStatus::REPLIED, its reply.
+		 */
+		typedef std::function<void(ReplyStatus status, const MigratoryDataMessage& reply)> ReplyCallback;
+
+	private :
+
+		// the states of the subscription to a reply subject
+		enum { SUBSCRIBING, SUBSCRIBED, DENIED };
+
+		struct Slot
+		{
+			std::string replySubject;
+			ReplyCallback callback;
+			// the request published once the reply subject is subscribed, if holding
+			MigratoryDataMessage held;
+			uint32_t generation;
+			int state;
+			bool inFlight;
+			bool holding;
+		};
+
+		// A call to reserve() waiting for the subscriptions of the first `end` reply subjects.
+		struct Reservation
+		{
+			size_t end;
+			size_t remaining;
+			std::shared_ptr<std::promise<size_t>> promise;
+		};
+
+		MigratoryDataClient& client;
+		MigratoryDataListener* listener;
+		std::string inbox;
+		size_t maxInFlight;
+		std::chrono::milliseconds resolution;
+		std::chrono::milliseconds quarantine;
+		std::chrono::steady_clock::time_point start;
+
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		std::vector<Slot> slots;
+		std::deque<uint32_t> free;
+		// the slots kept out of use, with the tick at which they become free, in that order
+		std::deque<std::pair<uint32_t, uint64_t>> quarantined;
+		std::list<Reservation> reservations;
+		MigratoryDataTimerWheel wheel;
+		size_t inFlight;
+		uint64_t lateReplies;
+		bool stopped;
+		std::thread timer;
+
+		// Prefix of the closures of the requests; a control character keeps them apart from the closures given by
+		// the application.
+		static const char* closurePrefix()
+		{
+			return "\x04" "request-";
+		}
+
+		uint64_t tickOf(std::chrono::steady_clock::time_point time) const
+		{
+			return static_cast<uint64_t>((time - start) / resolution);
+		}
+
+		// Called with the mutex held; subscribe the new subjects with the mutex released.
+		void grow(size_t count, std::vector<std::string>& subscribed)
+		{
+			for (size_t i = 0; i < count && slots.size() < maxInFlight; i++)
+			{
+				uint32_t index = static_cast<uint32_t>(slots.size());
+				Slot slot;
+				slot.replySubject = inbox + "/" + std::to_string(index);
+				slot.generation = 0;
+				slot.state = SUBSCRIBING;
+				slot.inFlight = false;
+				slot.holding = false;
+				slots.push_back(std::move(slot));
+				free.push_back(index);
+				subscribed.push_back(slots.back().replySubject);
+			}
+		}
+
+		// Called with the mutex held; return the callback of the request if it was still in flight. The slot of a
+		// replied request is free at once, the one of a request which timed out or failed after its quarantine.
+		ReplyCallback release(uint32_t index, uint32_t generation, bool replied)
+		{
+			ReplyCallback callback;
+			if (index >= slots.size() || !slots[index].inFlight || slots[index].generation != generation)
+			{
+				return callback;
+			}
+			Slot& slot = slots[index];
+			callback = std::move(slot.callback);
+			slot.callback = ReplyCallback();
+			slot.held = MigratoryDataMessage();
+			slot.holding = false;
+			slot.inFlight = false;
+			slot.generation++;
+			wheel.cancel(index);
+			inFlight--;
+			if (slot.state == DENIED)
+			{
+				return callback;
+			}
+			if (replied)
+			{
+				free.push_back(index);
+			}
+			else
+			{
+				if (quarantined.empty())
+				{
+					wakeUp.notify_one();
+				}
+				quarantined.push_back(std::make_pair(index, tickOf(std::chrono::steady_clock::now() + quarantine)));
+			}
+			return callback;
+		}
+
+		// Called with the mutex held; count the subscription of a reply subject as settled for the reservations
+		// covering it, and move the completed ones to `done`.
+		void settle(uint32_t index, std::vector<std::pair<std::shared_ptr<std::promise<size_t>>, size_t>>& done)
+		{
+			for (auto it = reservations.begin(); it != reservations.end();)
+			{
+				if (index < it->end && --it->remaining == 0)
+				{
+					done.push_back(std::make_pair(it->promise, allowed(it->end)));
+					it = reservations.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		// Called with the mutex held; return the number of reply subjects allowed among the first `end` ones.
+		size_t allowed(size_t end) const
+		{
+			size_t count = 0;
+			for (size_t i = 0; i < end; i++)
+			{
+				count += slots[i].state == SUBSCRIBED ? 1 : 0;
+			}
+			return count;
+		}
+
+		// Return the index of the slot of an inbox subject, or -1.
+		int64_t indexOf(const std::string& subject) const
+		{
+			if (subject.size() <= inbox.size() + 1 || subject.compare(0, inbox.size(), inbox) != 0
+				|| subject[inbox.size()] != '/')
+			{
+				return -1;
+			}
+			char* end;
+			unsigned long index = strtoul(subject.c_str() + inbox.size() + 1, &end, 10);
+			return *end == '\0' ? static_cast<int64_t>(index) : -1;
+		}
+
+		// Publish the request held by a slot whose reply subject is allowed, or fail it if the subject is denied.
+		void subscriptionSettled(uint32_t index, bool allow)
+		{
+			std::vector<std::pair<std::shared_ptr<std::promise<size_t>>, size_t>> done;
+			MigratoryDataMessage held;
+			bool publish = false;
+			ReplyCallback callback;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (index >= slots.size())
+				{
+					return;
+				}
+				Slot& slot = slots[index];
+				bool settling = slot.state == SUBSCRIBING;
+				if (allow)
+				{
+					if (slot.state == DENIED && !slot.inFlight)
+					{
+						// allowed again, after a reconnection for instance
+						free.push_back(index);
+					}
+					slot.state = SUBSCRIBED;
+					if (slot.holding)
+					{
+						held = std::move(slot.held);
+						slot.held = MigratoryDataMessage();
+						slot.holding = false;
+						publish = true;
+					}
+				}
+				else
+				{
+					slot.state = DENIED;
+					if (slot.inFlight)
+					{
+						callback = release(index, slot.generation, false);
+					}
+				}
+				if (settling)
+				{
+					settle(index, done);
+				}
+			}
+			if (publish)
+			{
+				client.publish(held);
+			}
+			if (callback)
+			{
+				MigratoryDataMessage none;
+				callback(ReplyStatus::SUBSCRIBE_DENIED, none);
+			}
+			for (auto& reservation : done)
+			{
+				reservation.first->set_value(reservation.second);
+			}
+		}
+
+		void run()
+		{
+			std::vector<uint32_t> expired;
+			std::vector<std::pair<ReplyCallback, uint32_t>> done;
+			MigratoryDataMessage none;
+			std::unique_lock<std::mutex> lock(mutex);
+			while (!stopped)
+			{
+				if (wheel.size() == 0 && quarantined.empty())
+				{
+					wakeUp.wait(lock, [this] { return stopped || wheel.size() > 0 || !quarantined.empty(); });
+					continue;
+				}
+				wakeUp.wait_for(lock, resolution);
+
+				uint64_t tick = tickOf(std::chrono::steady_clock::now());
+				while (!quarantined.empty() && quarantined.front().second <= tick)
+				{
+					uint32_t index = quarantined.front().first;
+					quarantined.pop_front();
+					if (slots[index].state != DENIED)
+					{
+						free.push_back(index);
+					}
+				}
+
+				expired.clear();
+				wheel.advance(tick, expired);
+				for (uint32_t index : expired)
+				{
+					ReplyCallback callback = release(index, slots[index].generation, false);
+					if (callback)
+					{
+						done.push_back(std::make_pair(std::move(callback), index));
+					}
+				}
+				if (done.empty())
+				{
+					continue;
+				}
+
+				lock.unlock();
+				for (auto& request : done)
+				{
+					request.first(ReplyStatus::TIMED_OUT, none);
+				}
+				done.clear();
+				lock.lock();
+			}
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataRequester object.
+		 *
+		 * \param client        the client used to publish the requests
+		 * \param listener      the listener to which the other messages and status notifications are forwarded
+		 * \param inbox         the subject prefixing the reply subjects, unique to this requester, such as
+		 *                      \c /inbox/ followed by an identifier of the client
+		 * \param maxInFlight   the maximum number of requests in flight, which is also the maximum number of reply
+		 *                      subjects subscribed
+		 * \param resolution    the precision of the timeouts
+		 * \param quarantine    the time during which the reply subject of a request which timed out or failed is not
+		 *                      reused, at least the longest time a reply may arrive late
+		 */
+		MigratoryDataRequester(MigratoryDataClient& client, MigratoryDataListener* listener, const std::string& inbox,
+			size_t maxInFlight = 65536, std::chrono::milliseconds resolution = std::chrono::milliseconds(1),
+			std::chrono::milliseconds quarantine = std::chrono::milliseconds(10000))
+			: client(client), listener(listener), inbox(inbox), maxInFlight(maxInFlight),
+			resolution(resolution.count() > 0 ? resolution : std::chrono::milliseconds(1)), quarantine(quarantine),
+			start(std::chrono::steady_clock::now()), wheel(maxInFlight < 65536 ? maxInFlight : 65536), inFlight(0),
+			lateReplies(0), stopped(false)
+		{
+			timer = std::thread([this] { run(); });
+		}
+
+		MigratoryDataRequester(const MigratoryDataRequester&) = delete;
+		MigratoryDataRequester& operator=(const MigratoryDataRequester&) = delete;
+
+		/**
+		 * Subscribe reply subjects in advance, in a single subscription, so that the first requests are not held
+		 * until their reply subjects are subscribed.
+		 *
+		 * \param count   the number of reply subjects expected to be needed, bounded by \c maxInFlight
+		 * \return a future holding, once the subscription of each of the first \c count reply subjects was allowed or
+		 *         denied, the number of them which were allowed
+		 */
+		std::future<size_t> reserve(size_t count)
+		{
+			std::shared_ptr<std::promise<size_t>> promise = std::make_shared<std::promise<size_t>>();
+			std::future<size_t> future = promise->get_future();
+			std::vector<std::string> subscribed;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (count > slots.size())
+				{
+					grow(count - slots.size(), subscribed);
+				}
+				Reservation reservation;
+				reservation.end = count < slots.size() ? count : slots.size();
+				reservation.remaining = 0;
+				for (size_t i = 0; i < reservation.end; i++)
+				{
+					reservation.remaining += slots[i].state == SUBSCRIBING ? 1 : 0;
+				}
+				if (reservation.remaining == 0)
+				{
+					promise->set_value(allowed(reservation.end));
+				}
+				else
+				{
+					reservation.promise = promise;
+					reservations.push_back(std::move(reservation));
+				}
+			}
+			if (!subscribed.empty())
+			{
+				client.subscribe(subscribed);
+			}
+			return future;
+		}
+
+		/**
+		 * Publish a request and call a function with its reply, or with the reason why it got none.
+		 *
+		 * \param message    the request; its reply subject and its closure are set by the requester
+		 * \param timeout    the maximum time to wait for the reply
+		 * \param callback   the function called once with the outcome of the request
+		 */
+		void request(const MigratoryDataMessage& message, std::chrono::milliseconds timeout, ReplyCallback callback)
+		{
+			std::vector<std::string> subscribed;
+			MigratoryDataMessage tracked;
+			bool rejected;
+			bool held = false;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				while (!free.empty() && slots[free.front()].state == DENIED)
+				{
+					free.pop_front();
+				}
+				if (free.empty())
+				{
+					// double the pool, subscribing the new subjects in a single call
+					grow(slots.empty() ? 1 : slots.size(), subscribed);
+				}
+				rejected = free.empty();
+				if (!rejected)
+				{
+					uint32_t index = free.front();
+					free.pop_front();
+					Slot& slot = slots[index];
+					slot.callback = std::move(callback);
+					slot.inFlight = true;
+					tracked = MigratoryDataMessage(message.getSubjectRef(), message.getContentRef(),
+						closurePrefix() + std::to_string(index) + "-" + std::to_string(slot.generation), message.getQos(),
+						false, slot.replySubject);
+					tracked.setCompressed(message.isCompressed());
+					if (slot.state == SUBSCRIBING)
+					{
+						slot.held = std::move(tracked);
+						slot.holding = true;
+						held = true;
+					}
+					inFlight++;
+					std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+					bool idle = wheel.size() == 0;
+					if (idle)
+					{
+						// the wheel is not advanced while empty; bring it to the current tick at once, nothing expires
+						std::vector<uint32_t> none;
+						wheel.advance(tickOf(now), none);
+					}
+					wheel.schedule(index, tickOf(now + timeout));
+					if (idle)
+					{
+						wakeUp.notify_one();
+					}
+				}
+			}
+			if (!subscribed.empty())
+			{
+				client.subscribe(subscribed);
+			}
+			if (rejected)
+			{
+				MigratoryDataMessage none;
+				callback(ReplyStatus::REJECTED, none);
+				return;
+			}
+			if (!held)
+			{
+				client.publish(tracked);
+			}
+		}
+
+		/**
+		 * Publish a request.
+		 *
+		 * \param message   the request; its reply subject and its closure are set by the requester
+		 * \param timeout   the maximum time to wait for the reply
+		 * \return a future holding the outcome of the request and, for ReplyStatus::REPLIED, its reply
+		 */
+		std::future<std::pair<ReplyStatus, MigratoryDataMessage>> request(const MigratoryDataMessage& message,
+			std::chrono::milliseconds timeout)
+		{
+			std::shared_ptr<std::promise<std::pair<ReplyStatus, MigratoryDataMessage>>> promise
+				= std::make_shared<std::promise<std::pair<ReplyStatus, MigratoryDataMessage>>>();
+			request(message, timeout, [promise](ReplyStatus status, const MigratoryDataMessage& reply) {
+				promise->set_value(std::make_pair(status, reply));
+			});
+			return promise->get_future();
+		}
+
+		/**
+		 * Complete the request of a reply, or forward the other messages to the wrapped listener.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			int64_t index = indexOf(message.getSubjectRef());
+			if (index < 0)
+			{
+				listener->onMessage(message);
+				return;
+			}
+
+			ReplyCallback callback;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (static_cast<size_t>(index) < slots.size())
+				{
+					// the reply subject does not carry the generation of the request; the quarantine of the slots
+					// released without a reply keeps the late replies from reaching a later request
+					callback = release(static_cast<uint32_t>(index), slots[index].generation, true);
+				}
+				if (!callback)
+				{
+					lateReplies++;
+					return;
+				}
+			}
+			callback(ReplyStatus::REPLIED, message);
+		}
+
+		/**
+		 * Complete the requests which could not be published, publish the requests held until their reply subject is
+		 * subscribed, then forward the status notification to the wrapped listener, unless it concerns a request or
+		 * allows the subscription of a reply subject.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			size_t prefix = strlen(closurePrefix());
+			if (info.compare(0, prefix, closurePrefix()) == 0)
+			{
+				if (status != client.NOTIFY_PUBLISH_OK)
+				{
+					char* end;
+					unsigned long index = strtoul(info.c_str() + prefix, &end, 10);
+					unsigned long generation = *end == '-' ? strtoul(end + 1, nullptr, 10) : 0;
+					ReplyCallback callback;
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						callback = release(static_cast<uint32_t>(index), static_cast<uint32_t>(generation), false);
+					}
+					if (callback)
+					{
+						MigratoryDataMessage none;
+						callback(ReplyStatus::PUBLISH_FAILED, none);
+					}
+				}
+				return;
+			}
+			if (status == client.NOTIFY_SUBSCRIBE_ALLOW || status == client.NOTIFY_SUBSCRIBE_DENY)
+			{
+				int64_t index = indexOf(info);
+				if (index >= 0)
+				{
+					bool allow = status == client.NOTIFY_SUBSCRIBE_ALLOW;
+					subscriptionSettled(static_cast<uint32_t>(index), allow);
+					if (allow)
+					{
+						return;
+					}
+				}
+			}
+			listener->onStatus(status, info);
+		}
+
+		/**
+		 * Get the number of reply subjects kept out of use after a request which timed out or failed.
+		 *
+		 * \return the number of reply subjects in quarantine
+		 */
+		size_t getQuarantined()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return quarantined.size();
+		}
+
+		/**
+		 * Get the number of requests waiting for their reply.
+		 *
+		 * \return the number of requests in flight
+		 */
+		size_t getInFlight()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return inFlight;
+		}
+
+		/**
+		 * Get the number of replies received after the timeout of their request, or received more than once.
+		 *
+		 * \return the number of dropped replies
+		 */
+		uint64_t getLateReplies()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return lateReplies;
+		}
+
+		/**
+		 * \brief Destructor.
+		 *
+		 * Stop the timeouts and unsubscribe the reply subjects. The requests still in flight never complete.
+		 */
+		virtual ~MigratoryDataRequester()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopped = true;
+				wakeUp.notify_all();
+			}
+			timer.join();
+
+			std::vector<std::string> subjects;
+			for (const Slot& slot : slots)
+			{
+				subjects.push_back(slot.replySubject);
+			}
+			if (!subjects.empty())
+			{
+				client.unsubscribe(subjects);
+			}
+		}
+	};
+
+}
+
+#endif // _MigratoryDataRequester_h_included_
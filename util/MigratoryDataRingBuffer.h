@@ -0,0 +1,166 @@
+#ifndef _MigratoryDataRingBuffer_h_included_
+#define _MigratoryDataRingBuffer_h_included_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace migratorydata
+{
+
+	/**
+	 * A bounded, lock-free, multi-producer multi-consumer ring buffer.
+	 *
+	 * Each slot carries a sequence number which tells producers and consumers whether the slot is free or filled for
+	 * the current lap of the ring, so neither side ever takes a lock or waits on the other one. The capacity is
+	 * rounded up to the next power of two.
+	 *
+	 * The element type must be default constructible and move assignable.
+	 */
+	template <typename T>
+	class MigratoryDataRingBuffer
+	{
+
+	private :
+
+		static const size_t CACHE_LINE = 64;
+
+		struct Slot
+		{
+			std::atomic<size_t> sequence;
+			T value;
+		};
+
+		std::unique_ptr<Slot[]> slots;
+		size_t mask;
+
+		char padding0[CACHE_LINE];
+		std::atomic<size_t> head;
+		char padding1[CACHE_LINE - sizeof(std::atomic<size_t>)];
+		std::atomic<size_t> tail;
+		char padding2[CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+		static size_t roundUp(size_t capacity)
+		{
+			size_t size = 2;
+			while (size < capacity)
+			{
+				size <<= 1;
+			}
+			return size;
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataRingBuffer object.
+		 *
+		 * \param capacity the minimum number of elements the ring can hold
+		 */
+		explicit MigratoryDataRingBuffer(size_t capacity)
+			: slots(new Slot[roundUp(capacity)]), mask(roundUp(capacity) - 1), head(0), tail(0)
+		{
+			for (size_t i = 0; i <= mask; i++)
+			{
+				slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		MigratoryDataRingBuffer(const MigratoryDataRingBuffer&) = delete;
+		MigratoryDataRingBuffer& operator=(const MigratoryDataRingBuffer&) = delete;
+
+		/**
+		 * Add an element at the tail of the ring, if the ring is not full.
+		 *
+		 * \param value the element to be moved into the ring
+		 * \return \c true if the element was added; \c false if the ring is full, in which case \c value is left untouched
+		 */
+		bool tryPush(T&& value)
+		{
+			size_t position = tail.load(std::memory_order_relaxed);
+			while (true)
+			{
+				Slot& slot = slots[position & mask];
+				std::ptrdiff_t distance = static_cast<std::ptrdiff_t>(slot.sequence.load(std::memory_order_acquire) - position);
+				if (distance == 0)
+				{
+					if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						slot.value = std::move(value);
+						slot.sequence.store(position + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (distance < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = tail.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		/**
+		 * Remove the element at the head of the ring, if the ring is not empty.
+		 *
+		 * \param value the destination into which the element is moved
+		 * \return \c true if an element was removed; \c false if the ring is empty
+		 */
+		bool tryPop(T& value)
+		{
+			size_t position = head.load(std::memory_order_relaxed);
+			while (true)
+			{
+				Slot& slot = slots[position & mask];
+				std::ptrdiff_t distance = static_cast<std::ptrdiff_t>(slot.sequence.load(std::memory_order_acquire) - (position + 1));
+				if (distance == 0)
+				{
+					if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						value = std::move(slot.value);
+						slot.sequence.store(position + mask + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (distance < 0)
+				{
+					return false;
+				}
+				else
+				{
+					position = head.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		/**
+		 * Get the number of elements in the ring.
+		 *
+		 * The value is exact only when no other thread pushes or pops concurrently.
+		 *
+		 * \return the number of elements in the ring
+		 */
+		size_t size() const
+		{
+			size_t t = tail.load(std::memory_order_acquire);
+			size_t h = head.load(std::memory_order_acquire);
+			return t > h ? t - h : 0;
+		}
+
+		/**
+		 * Get the maximum number of elements the ring can hold.
+		 *
+		 * \return the capacity of the ring
+		 */
+		size_t capacity() const
+		{
+			return mask + 1;
+		}
+	};
+
+}
+
+#endif // _MigratoryDataRingBuffer_h_included_
@@ -0,0 +1,418 @@
+#ifndef _MigratoryDataSequenceTracker_h_included_
+#define _MigratoryDataSequenceTracker_h_included_
+
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * A listener which tracks the epoch and the sequence number of the messages of each subject, detects the gaps in
+	 * the stream of a subject, and recovers only the missing messages from the cache of the servers.
+	 *
+	 * When a message of a subject has a sequence number higher than the next expected one, the missing range is
+	 * recorded and, after a short delay which batches the recoveries of many subjects, the subject is subscribed again
+	 * with just enough history to cover the range, as with \link MigratoryDataClient.subscribeWithHistory() \endlink.
+	 * The historical messages of the missing range are delivered, with their type MessageType::HISTORICAL, as they
+	 * arrive; the other ones were already delivered and are dropped, as are all the duplicated messages. The same
+	 * applies after \link MigratoryDataClient.NOTIFY_DATA_RESYNC \endlink, for which the library only delivers the most
+	 * recent retained message: the messages between the last delivered one and the retained one are recovered when
+	 * still cached, instead of being lost.
+	 *
+	 * A subject has at most one missing range being recovered; the messages of a range larger than \c maxRecovery, of
+	 * a gap detected while a range is being recovered, or of a range not recovered within \c timeout are counted as
+	 * lost. A new epoch starts the tracking of the subject over. The notifications
+	 * \link MigratoryDataClient.NOTIFY_SUBSCRIBE_ALLOW \endlink of the subscriptions made for a recovery are not
+	 * forwarded.
+	 *
+	 * A recovery unsubscribes from the subject before subscribing to it again with history. If the new subscription
+	 * is denied, for instance because the entitlements changed meanwhile, the subject is left unsubscribed: the
+	 * missing range is counted as lost and the notification \link MigratoryDataClient.NOTIFY_SUBSCRIBE_DENY \endlink
+	 * is forwarded, so that the wrapped listener learns that the subscription was dropped.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the wrapped listener,
+	 * and destroy it only after \link MigratoryDataClient.disconnect() \endlink.
+	 */
+	class MigratoryDataSequenceTracker : public MigratoryDataListener
+	{
+
+	private :
+
+		struct State
+		{
+			int32_t epoch;
+			// the highest sequence number delivered
+			int32_t seq;
+			// the next and the last sequence number of the missing range, if gapNext <= gapLast
+			int32_t gapNext;
+			int32_t gapLast;
+			// true after NOTIFY_DATA_RESYNC, until the next message
+			bool resync;
+			// true from the subscription made for a recovery until its subscribe notification
+			bool resubscribing;
+		};
+
+		MigratoryDataClient& client;
+		MigratoryDataListener* listener;
+		int maxRecovery;
+		std::chrono::milliseconds timeout;
+		std::chrono::milliseconds delay;
+
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		std::unordered_map<std::string, State> states;
+		std::unordered_map<std::string, std::chrono::steady_clock::time_point> recovering;
+		std::unordered_set<std::string> requested;
+		bool stopped;
+		std::thread recoverer;
+
+		uint64_t gaps;
+		uint64_t recovered;
+		uint64_t lost;
+		uint64_t duplicates;
+		uint64_t epochResets;
+
+		static bool hasGap(const State& state)
+		{
+			return state.gapNext <= state.gapLast;
+		}
+
+		// Called with the mutex held.
+		void abandon(State& state, const std::string& subject)
+		{
+			if (hasGap(state))
+			{
+				lost += static_cast<uint64_t>(state.gapLast - state.gapNext) + 1;
+				state.gapNext = 1;
+				state.gapLast = 0;
+				recovering.erase(subject);
+			}
+		}
+
+		// Called with the mutex held; return true if the message is to be delivered.
+		bool track(const MigratoryDataMessage& message)
+		{
+			const std::string& subject = message.getSubjectRef();
+			int32_t epoch = message.getEpoch();
+			int32_t seq = message.getSeq();
+
+			auto it = states.find(subject);
+			if (it == states.end())
+			{
+				State state = { epoch, seq, 1, 0, false, false };
+				states.emplace(subject, state);
+				return true;
+			}
+
+			State& state = it->second;
+			bool resync = state.resync;
+			state.resync = false;
+			if (epoch != state.epoch
+				|| (message.getMessageType() == MessageType::SNAPSHOT && !resync && !state.resubscribing))
+			{
+				if (epoch != state.epoch)
+				{
+					epochResets++;
+				}
+				abandon(state, subject);
+				state.epoch = epoch;
+				state.seq = seq;
+				return true;
+			}
+
+			if (seq <= state.seq)
+			{
+				if (hasGap(state) && seq >= state.gapNext && seq <= state.gapLast)
+				{
+					lost += static_cast<uint64_t>(seq - state.gapNext);
+					recovered++;
+					state.gapNext = seq + 1;
+					if (!hasGap(state))
+					{
+						recovering.erase(subject);
+					}
+					return true;
+				}
+				duplicates++;
+				return false;
+			}
+
+			// in 64 bits, as state.seq + 1 overflows at INT32_MAX
+			if (static_cast<int64_t>(seq) > static_cast<int64_t>(state.seq) + 1)
+			{
+				gaps++;
+				int64_t missing = static_cast<int64_t>(seq) - state.seq - 1;
+				if (!hasGap(state) && missing <= maxRecovery)
+				{
+					state.gapNext = state.seq + 1;
+					state.gapLast = seq - 1;
+					recovering[subject] = std::chrono::steady_clock::now() + delay + timeout;
+					requested.insert(subject);
+				}
+				else
+				{
+					lost += static_cast<uint64_t>(missing);
+				}
+			}
+			state.seq = seq;
+			return true;
+		}
+
+		void run()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (!stopped)
+			{
+				wakeUp.wait_for(lock, delay);
+				if (stopped)
+				{
+					return;
+				}
+
+				std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+				for (auto it = recovering.begin(); it != recovering.end();)
+				{
+					if (it->second <= now)
+					{
+						State& state = states[it->first];
+						lost += static_cast<uint64_t>(state.gapLast - state.gapNext) + 1;
+						state.gapNext = 1;
+						state.gapLast = 0;
+						it = recovering.erase(it);
+					}
+					else
+					{
+						++it;
+					}
+				}
+
+				// group the subjects by the number of historical messages, rounded up to a power of two
+				std::map<int, std::vector<std::string>> batches;
+				for (const std::string& subject : requested)
+				{
+					auto it = states.find(subject);
+					if (it == states.end() || !hasGap(it->second))
+					{
+						continue;
+					}
+					State& state = it->second;
+					state.resubscribing = true;
+					// twice the messages from the start of the range, to allow for the messages published meanwhile
+					int64_t needed = 2 * (static_cast<int64_t>(state.seq) - state.gapNext + 1);
+					int count = 1;
+					while (count < needed && count < maxRecovery)
+					{
+						count <<= 1;
+					}
+					batches[count < maxRecovery ? count : maxRecovery].push_back(subject);
+				}
+				requested.clear();
+				if (batches.empty())
+				{
+					continue;
+				}
+
+				lock.unlock();
+				for (auto& batch : batches)
+				{
+					client.unsubscribe(batch.second);
+					client.subscribeWithHistory(batch.second, batch.first);
+				}
+				lock.lock();
+			}
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataSequenceTracker object.
+		 *
+		 * \param client        the client used to recover the missing messages
+		 * \param listener      the listener to which the messages and the status notifications are forwarded
+		 * \param maxRecovery   the maximum number of historical messages requested for a subject, at most the number of
+		 *                      messages cached per subject by the servers, \c MaxCachedMessagesPerSubject
+		 * \param timeout       the time after which the messages of a missing range not recovered yet are counted as lost
+		 * \param delay         the interval at which the recoveries are batched, at least one millisecond
+		 */
+		MigratoryDataSequenceTracker(MigratoryDataClient& client, MigratoryDataListener* listener, int maxRecovery = 1000,
+			std::chrono::milliseconds timeout = std::chrono::milliseconds(5000),
+			std::chrono::milliseconds delay = std::chrono::milliseconds(50))
+			: client(client), listener(listener), maxRecovery(maxRecovery > 0 ? maxRecovery : 1), timeout(timeout),
+			delay(delay.count() > 0 ? delay : std::chrono::milliseconds(1)), stopped(false), gaps(0), recovered(0), lost(0),
+			duplicates(0), epochResets(0)
+		{
+			recoverer = std::thread([this] { run(); });
+		}
+
+		MigratoryDataSequenceTracker(const MigratoryDataSequenceTracker&) = delete;
+		MigratoryDataSequenceTracker& operator=(const MigratoryDataSequenceTracker&) = delete;
+
+		/**
+		 * Forget the state of subjects, for instance after unsubscribing from them.
+		 *
+		 * \param subjects   subjects no longer tracked
+		 */
+		void forget(const std::vector<std::string>& subjects)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const std::string& subject : subjects)
+			{
+				states.erase(subject);
+				recovering.erase(subject);
+			}
+		}
+
+		/**
+		 * Forward the message to the wrapped listener, unless it was already delivered.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			bool deliver;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				deliver = track(message);
+			}
+			if (deliver)
+			{
+				listener->onMessage(message);
+			}
+		}
+
+		/**
+		 * Track the resynchronizations and the subscriptions made for a recovery, then forward the status notification
+		 * to the wrapped listener, unless it allows the subscription of a recovery; a denied recovery is forwarded, as
+		 * the subject is then no longer subscribed.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			if (status == client.NOTIFY_DATA_RESYNC)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = states.find(info);
+				if (it != states.end())
+				{
+					it->second.resync = true;
+				}
+			}
+			else if (status == client.NOTIFY_SUBSCRIBE_ALLOW || status == client.NOTIFY_SUBSCRIBE_DENY)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				auto it = states.find(info);
+				if (it != states.end() && it->second.resubscribing)
+				{
+					it->second.resubscribing = false;
+					if (status == client.NOTIFY_SUBSCRIBE_ALLOW)
+					{
+						return;
+					}
+					// the subject was unsubscribed for the recovery and is no longer subscribed; forward the denial
+					abandon(it->second, info);
+				}
+			}
+			listener->onStatus(status, info);
+		}
+
+		/**
+		 * Get the number of gaps detected in the streams of the subjects.
+		 *
+		 * \return the number of gaps
+		 */
+		uint64_t getGaps()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return gaps;
+		}
+
+		/**
+		 * Get the number of missing messages recovered and delivered.
+		 *
+		 * \return the number of recovered messages
+		 */
+		uint64_t getRecoveredMessages()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return recovered;
+		}
+
+		/**
+		 * Get the number of missing messages which could not be recovered.
+		 *
+		 * \return the number of lost messages
+		 */
+		uint64_t getLostMessages()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return lost;
+		}
+
+		/**
+		 * Get the number of messages dropped because they were already delivered.
+		 *
+		 * \return the number of duplicated messages
+		 */
+		uint64_t getDuplicateMessages()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return duplicates;
+		}
+
+		/**
+		 * Get the number of times the epoch of a subject changed, after which its messages cannot be compared with
+		 * the previous ones.
+		 *
+		 * \return the number of epoch changes
+		 */
+		uint64_t getEpochResets()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return epochResets;
+		}
+
+		/**
+		 * Get the number of subjects whose missing messages are being recovered.
+		 *
+		 * \return the number of subjects being recovered
+		 */
+		size_t getRecovering()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return recovering.size();
+		}
+
+		/**
+		 * \brief Destructor.
+		 *
+		 * Stop the recoveries.
+		 */
+		virtual ~MigratoryDataSequenceTracker()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopped = true;
+				wakeUp.notify_all();
+			}
+			recoverer.join();
+		}
+	};
+
+}
+
+#endif // _MigratoryDataSequenceTracker_h_included_
@@ -0,0 +1,394 @@
+#ifndef _MigratoryDataServerSelector_h_included_
+#define _MigratoryDataServerSelector_h_included_
+
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+
+#if defined (_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * The way a \link MigratoryDataServerSelector \endlink turns the measured round-trip times into weights.
+	 */
+	enum class SelectionPolicy {
+
+		/**
+		 * Give the full weight to the reachable server with the lowest round-trip time, and the minimum weight to the
+		 * other servers, which are only used for failover.
+		 */
+		LOWEST_LATENCY,
+
+		/**
+		 * Weight each reachable server in inverse proportion to its round-trip time, so a server twice as far as the
+		 * nearest one gets half of its weight.
+		 */
+		WEIGHTED
+
+	};
+
+	/**
+	 * A listener which measures the round-trip time to each server of the cluster and gives the client a servers
+	 * list weighted accordingly, so that the client connects, and reconnects after a failure, to the nearest healthy
+	 * servers.
+	 *
+	 * The round-trip time of a server is the time needed to open a TCP connection to it, smoothed over the successive
+	 * probes so that the servers which recently responded well keep being preferred. The servers are probed when
+	 * \link probe() \endlink is called, typically before \link MigratoryDataClient.connect() \endlink, then again in
+	 * the background each time \link MigratoryDataClient.NOTIFY_SERVER_DOWN \endlink is notified and, optionally, at
+	 * a regular interval. The weights given in the servers list, as accepted by
+	 * \link MigratoryDataClient.setServers() \endlink, scale the computed weights; unreachable servers get the minimum
+	 * weight, so they are still tried for failover, while a server given a weight of 0 keeps it.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the wrapped listener,
+	 * and destroy it only after \link MigratoryDataClient.disconnect() \endlink.
+	 */
+	class MigratoryDataServerSelector : public MigratoryDataListener
+	{
+
+	private :
+
+		struct Server
+		{
+			std::string address;
+			int weight;
+			// smoothed round-trip time in microseconds, at least 1, or a negative value if the server was never reachable
+			double rtt;
+			bool reachable;
+		};
+
+		MigratoryDataClient& client;
+		MigratoryDataListener* listener;
+		SelectionPolicy policy;
+		std::chrono::milliseconds timeout;
+		std::chrono::milliseconds interval;
+
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		std::vector<Server> servers;
+		bool requested;
+		bool stopped;
+		std::thread prober;
+
+		// Open a TCP connection to host:port and return the time it took in microseconds, or -1 on failure.
+		static long long connectTime(const std::string& address, std::chrono::milliseconds timeout)
+		{
+			size_t colon = address.rfind(':');
+			if (colon == std::string::npos)
+			{
+				return -1;
+			}
+			std::string host = address.substr(0, colon);
+			std::string port = address.substr(colon + 1);
+			if (host.size() > 1 && host[0] == '[' && host[host.size() - 1] == ']')
+			{
+				host = host.substr(1, host.size() - 2);
+			}
+
+			addrinfo hints = addrinfo();
+			hints.ai_family = AF_UNSPEC;
+			hints.ai_socktype = SOCK_STREAM;
+			addrinfo* result = nullptr;
+			if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0 || result == nullptr)
+			{
+				return -1;
+			}
+
+			long long elapsed = -1;
+#if defined (_WIN32)
+			SOCKET fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+			if (fd != INVALID_SOCKET)
+			{
+				u_long nonBlocking = 1;
+				ioctlsocket(fd, FIONBIO, &nonBlocking);
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				connect(fd, result->ai_addr, static_cast<int>(result->ai_addrlen));
+				fd_set writable;
+				fd_set failed;
+				FD_ZERO(&writable);
+				FD_ZERO(&failed);
+				FD_SET(fd, &writable);
+				FD_SET(fd, &failed);
+				timeval limit = { static_cast<long>(timeout.count() / 1000), static_cast<long>(timeout.count() % 1000 * 1000) };
+				if (select(0, nullptr, &writable, &failed, &limit) > 0 && FD_ISSET(fd, &writable))
+				{
+					elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+				}
+				closesocket(fd);
+			}
+#else
+			int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+			if (fd >= 0)
+			{
+				fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				if (connect(fd, result->ai_addr, result->ai_addrlen) == 0)
+				{
+					elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+				}
+				else
+				{
+					pollfd descriptor = { fd, POLLOUT, 0 };
+					int error = 0;
+					socklen_t length = sizeof(error);
+					if (poll(&descriptor, 1, static_cast<int>(timeout.count())) == 1
+						&& getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0)
+					{
+						elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+					}
+				}
+				close(fd);
+			}
+#endif
+			freeaddrinfo(result);
+			return elapsed;
+		}
+
+		// Split an entry of the servers list into its weight, 100 by default, and its address.
+		static int weightOf(const std::string& server, std::string& address)
+		{
+			size_t space = server.find(' ');
+			if (space != std::string::npos && space > 0 && isdigit(static_cast<unsigned char>(server[0])))
+			{
+				address = server.substr(space + 1);
+				return atoi(server.substr(0, space).c_str());
+			}
+			address = server;
+			return 100;
+		}
+
+		// Called with the mutex held.
+		std::vector<std::string> weighted() const
+		{
+			double best = -1;
+			for (const Server& server : servers)
+			{
+				if (server.reachable && (best < 0 || server.rtt < best))
+				{
+					best = server.rtt;
+				}
+			}
+
+			std::vector<std::string> result;
+			for (const Server& server : servers)
+			{
+				int weight = server.weight;
+				if (best >= 0)
+				{
+					double share = !server.reachable ? 0 : policy == SelectionPolicy::WEIGHTED ? best / server.rtt
+						: server.rtt <= best ? 1 : 0;
+					weight = static_cast<int>(server.weight * share + 0.5);
+					// keep the servers given a weight by the operator in the list, but never enable a disabled one
+					weight = weight > 0 || server.weight <= 0 ? weight : 1;
+				}
+				result.push_back(std::to_string(weight) + " " + server.address);
+			}
+			return result;
+		}
+
+		void run()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (!stopped)
+			{
+				if (interval.count() > 0)
+				{
+					wakeUp.wait_for(lock, interval, [this] { return stopped || requested; });
+				}
+				else
+				{
+					wakeUp.wait(lock, [this] { return stopped || requested; });
+				}
+				if (stopped)
+				{
+					return;
+				}
+				requested = false;
+				lock.unlock();
+				std::vector<std::string> list = probe();
+				client.setServers(list);
+				lock.lock();
+			}
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataServerSelector object.
+		 *
+		 * \param client     the client whose servers list is maintained
+		 * \param listener   the listener to which the messages and the status notifications are forwarded
+		 * \param servers    the servers of the cluster, optionally prefixed with their weight, as accepted by
+		 *                   \link MigratoryDataClient.setServers() \endlink
+		 * \param policy     the way the round-trip times are turned into weights
+		 * \param timeout    the maximum time to wait for a server to accept a probe connection
+		 * \param interval   the interval at which the servers are probed in the background, or \c 0 to probe them
+		 *                   only after a connection failure
+		 */
+		MigratoryDataServerSelector(MigratoryDataClient& client, MigratoryDataListener* listener,
+			const std::vector<std::string>& servers, SelectionPolicy policy, std::chrono::milliseconds timeout,
+			std::chrono::milliseconds interval = std::chrono::milliseconds(0))
+			: client(client), listener(listener), policy(policy), timeout(timeout), interval(interval),
+			requested(false), stopped(false)
+		{
+#if defined (_WIN32)
+			WSADATA data;
+			WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+			for (const std::string& entry : servers)
+			{
+				Server server;
+				server.weight = weightOf(entry, server.address);
+				server.rtt = -1;
+				server.reachable = false;
+				this->servers.push_back(server);
+			}
+			prober = std::thread([this] { run(); });
+		}
+
+		MigratoryDataServerSelector(const MigratoryDataServerSelector&) = delete;
+		MigratoryDataServerSelector& operator=(const MigratoryDataServerSelector&) = delete;
+
+		/**
+		 * Probe all the servers concurrently, each on its own thread, and return the weighted servers list.
+		 *
+		 * A probe takes about the time needed to reach the farthest reachable server, and at most \c timeout plus the
+		 * time needed to resolve the addresses, however many servers are unreachable.
+		 *
+		 * \return the servers list to be given to \link MigratoryDataClient.setServers() \endlink
+		 */
+		std::vector<std::string> probe()
+		{
+			std::vector<std::string> addresses;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				for (const Server& server : servers)
+				{
+					addresses.push_back(server.address);
+				}
+			}
+
+			std::vector<long long> times(addresses.size(), -1);
+			std::vector<std::thread> probes;
+			for (size_t i = 0; i < addresses.size(); i++)
+			{
+				probes.emplace_back([this, &addresses, &times, i] { times[i] = connectTime(addresses[i], timeout); });
+			}
+			for (std::thread& thread : probes)
+			{
+				thread.join();
+			}
+
+			std::lock_guard<std::mutex> lock(mutex);
+			for (size_t i = 0; i < servers.size(); i++)
+			{
+				Server& server = servers[i];
+				server.reachable = times[i] >= 0;
+				if (server.reachable)
+				{
+					// a connection to a local server may take less than a microsecond, which would divide zero by zero
+					double time = times[i] > 0 ? static_cast<double>(times[i]) : 1.0;
+					server.rtt = server.rtt < 0 ? time : 0.7 * server.rtt + 0.3 * time;
+				}
+			}
+			return weighted();
+		}
+
+		/**
+		 * Probe all the servers and give the weighted servers list to the client.
+		 */
+		void apply()
+		{
+			std::vector<std::string> list = probe();
+			client.setServers(list);
+		}
+
+		/**
+		 * Get the smoothed round-trip time to a server.
+		 *
+		 * \param address   the address of the server, without its weight
+		 * \return the round-trip time in microseconds, or a negative value if the server is not reachable
+		 */
+		double getRoundTripTime(const std::string& address)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const Server& server : servers)
+			{
+				if (server.address == address)
+				{
+					return server.reachable ? server.rtt : -1;
+				}
+			}
+			return -1;
+		}
+
+		/**
+		 * Forward the message to the wrapped listener.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			listener->onMessage(message);
+		}
+
+		/**
+		 * Request the servers to be probed again in the background after a connection failure, then forward the status
+		 * notification to the wrapped listener.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			if (status == client.NOTIFY_SERVER_DOWN)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				requested = true;
+				wakeUp.notify_one();
+			}
+			listener->onStatus(status, info);
+		}
+
+		/**
+		 * \brief Destructor.
+		 *
+		 * Stop the background probes.
+		 */
+		virtual ~MigratoryDataServerSelector()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopped = true;
+				wakeUp.notify_all();
+			}
+			prober.join();
+#if defined (_WIN32)
+			WSACleanup();
+#endif
+		}
+	};
+
+}
+
+#endif // _MigratoryDataServerSelector_h_included_
@@ -0,0 +1,312 @@
+#ifndef _MigratoryDataShardedClient_h_included_
+#define _MigratoryDataShardedClient_h_included_
+
+#include "MigratoryDataClient.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * A client which spreads its subjects over several connections to the MigratoryData cluster.
+	 *
+	 * Each connection is a \link MigratoryDataClient \endlink with its own network thread and its own failover, and
+	 * each subject is hashed to exactly one connection, which subscribes to it and publishes its messages, so the
+	 * messages of a subject keep their order while the decoding of the messages of different subjects runs on
+	 * several cores. The connections can use the same server or, with \link setServers() \endlink, prefer different
+	 * members of the cluster.
+	 *
+	 * The listener receives the messages and the status notifications of all the connections, concurrently, so it
+	 * must be thread-safe; the connection-level notifications, such as
+	 * \link MigratoryDataClient.NOTIFY_SERVER_UP \endlink, are received once per connection.
+	 */
+	class MigratoryDataShardedClient
+	{
+
+	private :
+
+		std::vector<std::unique_ptr<MigratoryDataClient>> clients;
+
+		std::vector<std::vector<std::string>> split(const std::vector<std::string>& subjects) const
+		{
+			std::vector<std::vector<std::string>> shards(clients.size());
+			for (const std::string& subject : subjects)
+			{
+				shards[shardOf(subject)].push_back(subject);
+			}
+			return shards;
+		}
+
+		// Split an entry of the servers list into its weight, 100 by default, and its address.
+		static int weightOf(const std::string& server, std::string& address)
+		{
+			size_t space = server.find(' ');
+			if (space != std::string::npos && space > 0 && isdigit(static_cast<unsigned char>(server[0])))
+			{
+				address = server.substr(space + 1);
+				return atoi(server.substr(0, space).c_str());
+			}
+			address = server;
+			return 100;
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataShardedClient object.
+		 *
+		 * \param connections   the number of connections; at least one
+		 */
+		explicit MigratoryDataShardedClient(int connections)
+		{
+			int count = connections > 0 ? connections : 1;
+			for (int i = 0; i < count; i++)
+			{
+				clients.emplace_back(new MigratoryDataClient());
+			}
+		}
+
+		MigratoryDataShardedClient(const MigratoryDataShardedClient&) = delete;
+		MigratoryDataShardedClient& operator=(const MigratoryDataShardedClient&) = delete;
+
+		/**
+		 * Get the number of connections.
+		 *
+		 * \return the number of connections
+		 */
+		int getConnections() const
+		{
+			return static_cast<int>(clients.size());
+		}
+
+		/**
+		 * Get the client of a connection, for instance to configure options not exposed by this class.
+		 *
+		 * \param connection   the index of the connection, from \c 0 to \link getConnections() \endlink - 1
+		 * \return the client of the connection
+		 */
+		MigratoryDataClient& getClient(int connection)
+		{
+			return *clients.at(connection);
+		}
+
+		/**
+		 * Get the connection serving a subject.
+		 *
+		 * \param subject   a subject
+		 * \return the index of the connection which subscribes to the subject and publishes its messages
+		 */
+		int shardOf(const std::string& subject) const
+		{
+			return static_cast<int>(std::hash<std::string>()(subject) % clients.size());
+		}
+
+		/**
+		 * Attach a thread-safe listener to all the connections.
+		 *
+		 * \param listener   an implementation of the \link MigratoryDataListener \endlink interface
+		 */
+		void setListener(MigratoryDataListener* listener)
+		{
+			for (auto& client : clients)
+			{
+				client->setListener(listener);
+			}
+		}
+
+		/**
+		 * Attach a thread-safe log listener to all the connections.
+		 *
+		 * \param logListener   an implementation of the \link MigratoryDataLogListener \endlink interface
+		 * \param logLevel      the logging threshold
+		 */
+		void setLogListener(MigratoryDataLogListener* logListener, MigratoryDataLogLevel logLevel)
+		{
+			for (auto& client : clients)
+			{
+				client->setLogListener(logListener, logLevel);
+			}
+		}
+
+		/**
+		 * Specify the MigratoryData servers of the cluster, as with \link MigratoryDataClient.setServers() \endlink.
+		 *
+		 * \param servers   the servers, optionally prefixed with their weight
+		 * \param spread    if \c true, the connection \c i prefers the server \c i modulo the number of servers, the
+		 *                  weights of the other servers being divided by ten for that connection, so the connections
+		 *                  are spread over the cluster while keeping all the servers for failover; if \c false, all the
+		 *                  connections use the weights as given
+		 */
+		void setServers(std::vector<std::string>& servers, bool spread = false)
+		{
+			for (size_t i = 0; i < clients.size(); i++)
+			{
+				std::vector<std::string> weighted = servers;
+				if (spread && servers.size() > 1)
+				{
+					for (size_t s = 0; s < servers.size(); s++)
+					{
+						if (s != i % servers.size())
+						{
+							std::string address;
+							int weight = weightOf(servers[s], address) / 10;
+							weighted[s] = std::to_string(weight > 0 ? weight : 1) + " " + address;
+						}
+					}
+				}
+				clients[i]->setServers(weighted);
+			}
+		}
+
+		/**
+		 * Assign an entitlement token to all the connections.
+		 *
+		 * \param token   an entitlement token
+		 */
+		void setEntitlementToken(std::string& token)
+		{
+			for (auto& client : clients)
+			{
+				client->setEntitlementToken(token);
+			}
+		}
+
+#if !defined (SSL_DISABLED)
+		/**
+		 * Configure whether to use SSL/TLS encryption for all the connections.
+		 *
+		 * \param encryption   if \c true, the connections are encrypted
+		 */
+		void setEncryption(bool encryption)
+		{
+			for (auto& client : clients)
+			{
+				client->setEncryption(encryption);
+			}
+		}
+#endif
+
+		/**
+		 * Define the transport type of all the connections.
+		 *
+		 * \param transport   MigratoryDataClient.TRANSPORT_HTTP or MigratoryDataClient.TRANSPORT_WEBSOCKET
+		 */
+		void setTransport(std::string transport)
+		{
+			for (auto& client : clients)
+			{
+				client->setTransport(transport);
+			}
+		}
+
+		/**
+		 * Connect all the connections.
+		 */
+		void connect()
+		{
+			for (auto& client : clients)
+			{
+				client->connect();
+			}
+		}
+
+		/**
+		 * Disconnect all the connections.
+		 */
+		void disconnect()
+		{
+			for (auto& client : clients)
+			{
+				client->disconnect();
+			}
+		}
+
+		/**
+		 * Subscribe to subjects, each on the connection serving it.
+		 *
+		 * \param subjects   subjects to subscribe
+		 */
+		void subscribe(const std::vector<std::string>& subjects)
+		{
+			std::vector<std::vector<std::string>> shards = split(subjects);
+			for (size_t i = 0; i < clients.size(); i++)
+			{
+				if (!shards[i].empty())
+				{
+					clients[i]->subscribe(shards[i]);
+				}
+			}
+		}
+
+		/**
+		 * Subscribe to subjects with history, each on the connection serving it.
+		 *
+		 * \param subjects                     subjects to subscribe
+		 * \param numberOfHistoricalMessages   the number of historical messages to be retrieved for each subject
+		 */
+		void subscribeWithHistory(const std::vector<std::string>& subjects, int numberOfHistoricalMessages)
+		{
+			std::vector<std::vector<std::string>> shards = split(subjects);
+			for (size_t i = 0; i < clients.size(); i++)
+			{
+				if (!shards[i].empty())
+				{
+					clients[i]->subscribeWithHistory(shards[i], numberOfHistoricalMessages);
+				}
+			}
+		}
+
+		/**
+		 * Unsubscribe from subjects, each on the connection serving it.
+		 *
+		 * \param subjects   subjects to unsubscribe
+		 */
+		void unsubscribe(const std::vector<std::string>& subjects)
+		{
+			std::vector<std::vector<std::string>> shards = split(subjects);
+			for (size_t i = 0; i < clients.size(); i++)
+			{
+				if (!shards[i].empty())
+				{
+					clients[i]->unsubscribe(shards[i]);
+				}
+			}
+		}
+
+		/**
+		 * Publish a message on the connection serving its subject.
+		 *
+		 * \param message A MigratoryDataMessage message
+		 */
+		void publish(MigratoryDataMessage& message)
+		{
+			clients[shardOf(message.getSubjectRef())]->publish(message);
+		}
+
+		/**
+		 * Return the subjects subscribed on all the connections.
+		 *
+		 * \param subjects   the vector which receives the subscribed subjects
+		 */
+		void getSubjects(std::vector<std::string>& subjects)
+		{
+			subjects.clear();
+			std::vector<std::string> shard;
+			for (auto& client : clients)
+			{
+				shard.clear();
+				client->getSubjects(shard);
+				subjects.insert(subjects.end(), shard.begin(), shard.end());
+			}
+		}
+	};
+
+}
+
+#endif // _MigratoryDataShardedClient_h_included_
@@ -0,0 +1,234 @@
+#ifndef _MigratoryDataSubjectCache_h_included_
+#define _MigratoryDataSubjectCache_h_included_
+
+#include "MigratoryDataListener.h"
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * A listener which keeps the latest message received for each subject, so that any thread can look up the
+	 * current value of a subject with \link getLastMessage() \endlink instead of maintaining its own map.
+	 *
+	 * Messages of type MessageType::SNAPSHOT, MessageType::UPDATE and MessageType::RECOVERED replace the cached
+	 * message of their subject; MessageType::HISTORICAL messages are older than the cached ones and are only
+	 * forwarded. The cached messages are immutable and shared, so a lookup hands out a reference-counted pointer
+	 * rather than a copy, which stays valid after the subject is updated or evicted.
+	 *
+	 * The subjects are spread over shards, each guarded by a reader-writer lock: lookups only take the lock of their
+	 * shard in shared mode, so they never wait for each other, and they wait for an update only while it swaps a
+	 * pointer. The memory used by the cached messages is capped; when the cap of a shard is exceeded, the subjects
+	 * least recently updated in that shard are evicted first.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink in place of the wrapped listener,
+	 * ahead of any listener which dispatches the messages to other threads.
+	 */
+	class MigratoryDataSubjectCache : public MigratoryDataListener
+	{
+
+	private :
+
+		struct Entry
+		{
+			std::shared_ptr<const MigratoryDataMessage> message;
+			size_t size;
+			std::list<std::string>::iterator recency;
+		};
+
+		struct Shard
+		{
+			mutable std::shared_timed_mutex mutex;
+			std::unordered_map<std::string, Entry> entries;
+			std::list<std::string> recency;
+			size_t size = 0;
+		};
+
+		MigratoryDataListener* listener;
+		std::vector<std::unique_ptr<Shard>> shards;
+		size_t maxShardSize;
+
+		Shard& shardOf(const std::string& subject) const
+		{
+			return *shards[std::hash<std::string>()(subject) % shards.size()];
+		}
+
+		static size_t sizeOf(const std::string& subject, const MigratoryDataMessage& message)
+		{
+			return sizeof(Entry) + sizeof(MigratoryDataMessage) + 2 * subject.size() + message.getContentRef().size()
+				+ message.getClosureRef().size() + message.getReplySubjectRef().size();
+		}
+
+		// Remove an entry, moving its message to `released` so that the caller frees it after unlocking the shard.
+		static void erase(Shard& shard, std::unordered_map<std::string, Entry>::iterator it,
+			std::vector<std::shared_ptr<const MigratoryDataMessage>>& released)
+		{
+			released.push_back(std::move(it->second.message));
+			shard.size -= it->second.size;
+			shard.recency.erase(it->second.recency);
+			shard.entries.erase(it);
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataSubjectCache object.
+		 *
+		 * \param listener   the listener to which the messages and the status notifications are forwarded; may be
+		 *                   \c nullptr if the cache is the only consumer of the messages
+		 * \param maxSize    the approximate maximum number of bytes used by the cached messages
+		 * \param shards     the number of shards; at least one
+		 */
+		MigratoryDataSubjectCache(MigratoryDataListener* listener, size_t maxSize, int shards = 64)
+			: listener(listener)
+		{
+			int count = shards > 0 ? shards : 1;
+			for (int i = 0; i < count; i++)
+			{
+				this->shards.emplace_back(new Shard());
+			}
+			maxShardSize = maxSize / count;
+		}
+
+		/**
+		 * Cache the message as the latest message of its subject, then forward it to the wrapped listener.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			if (message.getMessageType() != MessageType::HISTORICAL)
+			{
+				// copied only as the key of a new entry
+				const std::string& subject = message.getSubjectRef();
+				size_t size = sizeOf(subject, message);
+				std::shared_ptr<const MigratoryDataMessage> cached = std::make_shared<const MigratoryDataMessage>(message);
+				Shard& shard = shardOf(subject);
+				std::vector<std::shared_ptr<const MigratoryDataMessage>> released;
+
+				std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+				auto it = shard.entries.find(subject);
+				if (it != shard.entries.end())
+				{
+					shard.size -= it->second.size;
+					shard.recency.splice(shard.recency.end(), shard.recency, it->second.recency);
+					it->second.message.swap(cached);
+					it->second.size = size;
+				}
+				else
+				{
+					Entry& entry = shard.entries[subject];
+					entry.message.swap(cached);
+					entry.size = size;
+					entry.recency = shard.recency.insert(shard.recency.end(), subject);
+				}
+				shard.size += size;
+
+				while (shard.size > maxShardSize && shard.entries.size() > 1)
+				{
+					erase(shard, shard.entries.find(shard.recency.front()), released);
+				}
+				lock.unlock();
+				// the previously cached message and the evicted ones, if any, are released when `cached` and
+				// `released` go out of scope, outside the lock
+			}
+
+			if (listener != nullptr)
+			{
+				listener->onMessage(message);
+			}
+		}
+
+		/**
+		 * Forward the status notification to the wrapped listener.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			if (listener != nullptr)
+			{
+				listener->onStatus(status, info);
+			}
+		}
+
+		/**
+		 * Get the latest message received for a subject.
+		 *
+		 * This method can be called concurrently from any number of threads.
+		 *
+		 * \param subject the subject to look up
+		 * \return the latest message received for the subject, or an empty pointer if the subject has no cached message
+		 */
+		std::shared_ptr<const MigratoryDataMessage> getLastMessage(const std::string& subject) const
+		{
+			Shard& shard = shardOf(subject);
+			std::shared_lock<std::shared_timed_mutex> lock(shard.mutex);
+			auto it = shard.entries.find(subject);
+			return it != shard.entries.end() ? it->second.message : std::shared_ptr<const MigratoryDataMessage>();
+		}
+
+		/**
+		 * Remove the cached message of a subject, typically after unsubscribing from it.
+		 *
+		 * \param subject the subject whose cached message is removed
+		 */
+		void remove(const std::string& subject)
+		{
+			Shard& shard = shardOf(subject);
+			std::vector<std::shared_ptr<const MigratoryDataMessage>> released;
+			std::unique_lock<std::shared_timed_mutex> lock(shard.mutex);
+			auto it = shard.entries.find(subject);
+			if (it != shard.entries.end())
+			{
+				erase(shard, it, released);
+			}
+			lock.unlock();
+		}
+
+		/**
+		 * Get the number of subjects having a cached message.
+		 *
+		 * \return the number of cached subjects
+		 */
+		size_t size() const
+		{
+			size_t count = 0;
+			for (auto& shard : shards)
+			{
+				std::shared_lock<std::shared_timed_mutex> lock(shard->mutex);
+				count += shard->entries.size();
+			}
+			return count;
+		}
+
+		/**
+		 * Get the approximate number of bytes used by the cached messages.
+		 *
+		 * \return the memory used by the cache, in bytes
+		 */
+		size_t getMemoryUsage() const
+		{
+			size_t total = 0;
+			for (auto& shard : shards)
+			{
+				std::shared_lock<std::shared_timed_mutex> lock(shard->mutex);
+				total += shard->size;
+			}
+			return total;
+		}
+	};
+
+}
+
+#endif // _MigratoryDataSubjectCache_h_included_
@@ -0,0 +1,188 @@
+#ifndef _MigratoryDataSubjectRouter_h_included_
+#define _MigratoryDataSubjectRouter_h_included_
+
+#include "MigratoryDataListener.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * A listener which routes each received message to the listener registered for its subject.
+	 *
+	 * Listeners are registered with \link addRoute() \endlink either for an exact subject, such as
+	 * \c /server/status, or for all the subjects starting with a prefix, written with a trailing \c *, such as
+	 * \c /server/ followed by \c * . A message is delivered to the listener of its exact subject if there is one, otherwise to the
+	 * listener of the longest matching prefix, otherwise to the default listener.
+	 *
+	 * The routes are kept in a character trie, so routing a message costs one step per character of its subject,
+	 * whatever the number of routes, and does not allocate memory. Routes can be changed while messages are routed.
+	 *
+	 * The status notifications are forwarded to the default listener.
+	 *
+	 * Register this listener with \link MigratoryDataClient.setListener() \endlink.
+	 */
+	class MigratoryDataSubjectRouter : public MigratoryDataListener
+	{
+
+	private :
+
+		enum : uint32_t { NONE = UINT32_MAX };
+
+		struct Node
+		{
+			// children sorted by character; a node rarely has more than a few dozen children
+			std::vector<std::pair<char, uint32_t>> children;
+			MigratoryDataListener* exact = nullptr;
+			MigratoryDataListener* prefix = nullptr;
+		};
+
+		MigratoryDataListener* defaultListener;
+		mutable std::shared_timed_mutex mutex;
+		std::vector<Node> nodes;
+
+		uint32_t child(uint32_t node, char c) const
+		{
+			const std::vector<std::pair<char, uint32_t>>& children = nodes[node].children;
+			auto it = std::lower_bound(children.begin(), children.end(), std::make_pair(c, uint32_t(0)),
+				[](const std::pair<char, uint32_t>& a, const std::pair<char, uint32_t>& b) { return a.first < b.first; });
+			return it != children.end() && it->first == c ? it->second : NONE;
+		}
+
+		uint32_t insert(const std::string& key)
+		{
+			uint32_t node = 0;
+			for (char c : key)
+			{
+				uint32_t next = child(node, c);
+				if (next == NONE)
+				{
+					next = static_cast<uint32_t>(nodes.size());
+					nodes.emplace_back();
+					std::vector<std::pair<char, uint32_t>>& children = nodes[node].children;
+					children.insert(std::upper_bound(children.begin(), children.end(), std::make_pair(c, next)), std::make_pair(c, next));
+				}
+				node = next;
+			}
+			return node;
+		}
+
+		static bool isPrefix(const std::string& pattern)
+		{
+			return !pattern.empty() && pattern[pattern.size() - 1] == '*';
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataSubjectRouter object.
+		 *
+		 * \param defaultListener   the listener which receives the messages matching no route, and the status
+		 *                          notifications; may be \c nullptr
+		 */
+		explicit MigratoryDataSubjectRouter(MigratoryDataListener* defaultListener)
+			: defaultListener(defaultListener), nodes(1)
+		{
+		}
+
+		/**
+		 * Route the messages of a subject, or of all the subjects starting with a prefix, to a listener.
+		 *
+		 * Registering a listener for a pattern which already has one replaces it.
+		 *
+		 * \param pattern    an exact subject, or a prefix followed by \c * to match all the subjects starting with
+		 *                   that prefix
+		 * \param listener   the listener which handles the matching messages
+		 */
+		void addRoute(const std::string& pattern, MigratoryDataListener* listener)
+		{
+			std::unique_lock<std::shared_timed_mutex> lock(mutex);
+			if (isPrefix(pattern))
+			{
+				nodes[insert(pattern.substr(0, pattern.size() - 1))].prefix = listener;
+			}
+			else
+			{
+				nodes[insert(pattern)].exact = listener;
+			}
+		}
+
+		/**
+		 * Remove the route of a subject or prefix given to \link addRoute() \endlink.
+		 *
+		 * \param pattern    the pattern of the route to be removed
+		 */
+		void removeRoute(const std::string& pattern)
+		{
+			addRoute(pattern, nullptr);
+		}
+
+		/**
+		 * Get the listener to which the messages of a subject are routed.
+		 *
+		 * \param subject   a subject
+		 * \return the listener of the exact subject, or of its longest matching prefix, or the default listener
+		 */
+		MigratoryDataListener* route(const std::string& subject) const
+		{
+			std::shared_lock<std::shared_timed_mutex> lock(mutex);
+			MigratoryDataListener* match = nodes[0].prefix;
+			uint32_t node = 0;
+			for (char c : subject)
+			{
+				node = child(node, c);
+				if (node == NONE)
+				{
+					break;
+				}
+				if (nodes[node].prefix != nullptr)
+				{
+					match = nodes[node].prefix;
+				}
+			}
+			if (node != NONE && nodes[node].exact != nullptr)
+			{
+				match = nodes[node].exact;
+			}
+			return match != nullptr ? match : defaultListener;
+		}
+
+		/**
+		 * Deliver the message to the listener of its subject.
+		 *
+		 * \param message An object of type \link MigratoryDataMessage \endlink .
+		 */
+		void onMessage(const MigratoryDataMessage& message)
+		{
+			MigratoryDataListener* listener = route(message.getSubjectRef());
+			if (listener != nullptr)
+			{
+				listener->onMessage(message);
+			}
+		}
+
+		/**
+		 * Forward the status notification to the default listener.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			if (defaultListener != nullptr)
+			{
+				defaultListener->onStatus(status, info);
+			}
+		}
+	};
+
+}
+
+#endif // _MigratoryDataSubjectRouter_h_included_
@@ -0,0 +1,228 @@
+#ifndef _MigratoryDataSubscriptionSet_h_included_
+#define _MigratoryDataSubscriptionSet_h_included_
+
+#include "MigratoryDataClient.h"
+
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * The subscriptions of a client, kept in a hash set and changed incrementally.
+	 *
+	 * Subscribing to a subject already subscribed, or unsubscribing from a subject not subscribed, costs a hash
+	 * lookup and does not reach the client; the other subjects are handed to \link MigratoryDataClient.subscribe()
+	 * \endlink and \link MigratoryDataClient.unsubscribe() \endlink in batches of at most \c batchSize subjects, so that
+	 * changing the subscriptions of a client with hundreds of thousands of subjects neither resends the subjects
+	 * already subscribed nor builds a single oversized request. The subscriptions can be counted, tested and iterated
+	 * without copying them, unlike with \link MigratoryDataClient.getSubjects() \endlink.
+	 *
+	 * All the subscriptions of the client must be changed through this object. It is safe to use from any thread.
+	 */
+	class MigratoryDataSubscriptionSet
+	{
+
+	private :
+
+		MigratoryDataClient& client;
+		size_t batchSize;
+		mutable std::mutex mutex;
+		std::unordered_set<std::string> subjects;
+		std::vector<std::string> batch;
+
+		void flush(bool subscribe, int numberOfHistoricalMessages)
+		{
+			if (batch.empty())
+			{
+				return;
+			}
+			if (!subscribe)
+			{
+				client.unsubscribe(batch);
+			}
+			else if (numberOfHistoricalMessages > 0)
+			{
+				client.subscribeWithHistory(batch, numberOfHistoricalMessages);
+			}
+			else
+			{
+				client.subscribe(batch);
+			}
+			batch.clear();
+		}
+
+		size_t add(const std::vector<std::string>& added, int numberOfHistoricalMessages)
+		{
+			size_t count = 0;
+			for (const std::string& subject : added)
+			{
+				if (subjects.insert(subject).second)
+				{
+					batch.push_back(subject);
+					count++;
+					if (batch.size() == batchSize)
+					{
+						flush(true, numberOfHistoricalMessages);
+					}
+				}
+			}
+			flush(true, numberOfHistoricalMessages);
+			return count;
+		}
+
+		size_t remove(const std::vector<std::string>& removed)
+		{
+			size_t count = 0;
+			for (const std::string& subject : removed)
+			{
+				if (subjects.erase(subject) > 0)
+				{
+					batch.push_back(subject);
+					count++;
+					if (batch.size() == batchSize)
+					{
+						flush(false, 0);
+					}
+				}
+			}
+			flush(false, 0);
+			return count;
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataSubscriptionSet object.
+		 *
+		 * \param client      the client whose subscriptions are managed, which must have no subscriptions yet
+		 * \param batchSize   the maximum number of subjects handed to the client in one call; at least one
+		 */
+		explicit MigratoryDataSubscriptionSet(MigratoryDataClient& client, size_t batchSize = 1000)
+			: client(client), batchSize(batchSize > 0 ? batchSize : 1)
+		{
+			batch.reserve(this->batchSize);
+		}
+
+		/**
+		 * Subscribe to the subjects not subscribed yet.
+		 *
+		 * \param subjects   subjects to subscribe
+		 * \return the number of subjects newly subscribed
+		 */
+		size_t subscribe(const std::vector<std::string>& subjects)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return add(subjects, 0);
+		}
+
+		/**
+		 * Subscribe with history to the subjects not subscribed yet, as with \link
+		 * MigratoryDataClient.subscribeWithHistory() \endlink.
+		 *
+		 * \param subjects                     subjects to subscribe
+		 * \param numberOfHistoricalMessages   the number of historical messages to be retrieved for each subject
+		 * \return the number of subjects newly subscribed
+		 */
+		size_t subscribeWithHistory(const std::vector<std::string>& subjects, int numberOfHistoricalMessages)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return add(subjects, numberOfHistoricalMessages);
+		}
+
+		/**
+		 * Unsubscribe from the subjects currently subscribed.
+		 *
+		 * \param subjects   subjects to unsubscribe
+		 * \return the number of subjects unsubscribed
+		 */
+		size_t unsubscribe(const std::vector<std::string>& subjects)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return remove(subjects);
+		}
+
+		/**
+		 * Apply a change of subscriptions in one step: unsubscribe from the subjects of \c removed which are subscribed,
+		 * then subscribe to the subjects of \c added which are not.
+		 *
+		 * \param added     subjects to subscribe
+		 * \param removed   subjects to unsubscribe
+		 */
+		void updateSubscriptions(const std::vector<std::string>& added, const std::vector<std::string>& removed)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			remove(removed);
+			add(added, 0);
+		}
+
+		/**
+		 * Make the subscriptions equal to a set of subjects, unsubscribing from the subjects which are not in it and
+		 * subscribing to the subjects which are not subscribed yet.
+		 *
+		 * \param target   the subjects to be subscribed once the call returns
+		 */
+		void setSubscriptions(const std::vector<std::string>& target)
+		{
+			std::unordered_set<std::string> wanted(target.begin(), target.end());
+			std::lock_guard<std::mutex> lock(mutex);
+			std::vector<std::string> removed;
+			for (const std::string& subject : subjects)
+			{
+				if (wanted.count(subject) == 0)
+				{
+					removed.push_back(subject);
+				}
+			}
+			remove(removed);
+			add(target, 0);
+		}
+
+		/**
+		 * Tell whether a subject is subscribed.
+		 *
+		 * \param subject   a subject
+		 * \return \c true if the subject is subscribed
+		 */
+		bool contains(const std::string& subject) const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return subjects.count(subject) > 0;
+		}
+
+		/**
+		 * Get the number of subscribed subjects.
+		 *
+		 * \return the number of subscribed subjects
+		 */
+		size_t size() const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return subjects.size();
+		}
+
+		/**
+		 * Call a function for each subscribed subject, in no particular order.
+		 *
+		 * The subscriptions are locked while the function runs, so it must not call the methods of this object.
+		 *
+		 * \param function   the function called with each subscribed subject
+		 */
+		void forEach(const std::function<void(const std::string&)>& function) const
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (const std::string& subject : subjects)
+			{
+				function(subject);
+			}
+		}
+	};
+
+}
+
+#endif // _MigratoryDataSubscriptionSet_h_included_
@@ -0,0 +1,217 @@
+#ifndef _MigratoryDataTimerWheel_h_included_
+#define _MigratoryDataTimerWheel_h_included_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * A hierarchical timer wheel which schedules, cancels and expires timers in constant time, for a large number of
+	 * timers such as the timeouts of the requests in flight.
+	 *
+	 * Time is counted in ticks of a resolution chosen by the caller. The wheel has four levels of 256 buckets; a timer
+	 * is placed in the bucket of the lowest level covering its deadline, and moved down a level each time the wheel
+	 * turns past the bucket holding it, so it expires at its exact tick, up to 2^32 ticks ahead. A timer is identified
+	 * by a small integer, typically the index of the object it belongs to, and the buckets are intrusive lists of
+	 * these identifiers, so scheduling a timer does not allocate memory once the wheel has grown to hold it.
+	 *
+	 * This class is not thread-safe.
+	 */
+	class MigratoryDataTimerWheel
+	{
+
+	private :
+
+		enum : uint32_t { NONE = UINT32_MAX };
+		enum : int { LEVELS = 4, BITS = 8, SLOTS = 1 << BITS };
+
+		struct Timer
+		{
+			uint64_t deadline;
+			uint32_t prev;
+			uint32_t next;
+			uint32_t bucket;
+		};
+
+		std::vector<Timer> timers;
+		std::vector<uint32_t> buckets;
+		uint64_t now;
+		size_t scheduled;
+
+		void link(uint32_t id)
+		{
+			Timer& timer = timers[id];
+			uint64_t delta = timer.deadline - now;
+			int level = 0;
+			while (level < LEVELS - 1 && delta >= (static_cast<uint64_t>(1) << (BITS * (level + 1))))
+			{
+				level++;
+			}
+			uint32_t bucket = static_cast<uint32_t>(level * SLOTS + ((timer.deadline >> (BITS * level)) & (SLOTS - 1)));
+			timer.bucket = bucket;
+			timer.prev = NONE;
+			timer.next = buckets[bucket];
+			if (timer.next != NONE)
+			{
+				timers[timer.next].prev = id;
+			}
+			buckets[bucket] = id;
+		}
+
+		void unlink(uint32_t id)
+		{
+			Timer& timer = timers[id];
+			if (timer.prev != NONE)
+			{
+				timers[timer.prev].next = timer.next;
+			}
+			else
+			{
+				buckets[timer.bucket] = timer.next;
+			}
+			if (timer.next != NONE)
+			{
+				timers[timer.next].prev = timer.prev;
+			}
+			timer.bucket = NONE;
+		}
+
+		void cascade(int level)
+		{
+			uint32_t bucket = static_cast<uint32_t>(level * SLOTS + ((now >> (BITS * level)) & (SLOTS - 1)));
+			uint32_t id = buckets[bucket];
+			buckets[bucket] = NONE;
+			while (id != NONE)
+			{
+				uint32_t next = timers[id].next;
+				link(id);
+				id = next;
+			}
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataTimerWheel object.
+		 *
+		 * \param capacity   the number of timers for which memory is reserved; the wheel grows beyond it as needed
+		 * \param now        the current tick
+		 */
+		explicit MigratoryDataTimerWheel(size_t capacity = 0, uint64_t now = 0)
+			: buckets(LEVELS * SLOTS, NONE), now(now), scheduled(0)
+		{
+			timers.reserve(capacity);
+		}
+
+		/**
+		 * Schedule a timer, or reschedule it if it is already scheduled.
+		 *
+		 * \param id         the identifier of the timer, a small integer
+		 * \param deadline   the tick at which the timer expires; a tick already reached expires the timer at the next
+		 *                   tick, and a tick more than 2^32 - 1 ticks ahead is brought back to that limit
+		 */
+		void schedule(uint32_t id, uint64_t deadline)
+		{
+			while (timers.size() <= id)
+			{
+				Timer timer = { 0, NONE, NONE, NONE };
+				timers.push_back(timer);
+			}
+			if (timers[id].bucket != NONE)
+			{
+				unlink(id);
+				scheduled--;
+			}
+			uint64_t limit = now + (static_cast<uint64_t>(1) << (BITS * LEVELS)) - 1;
+			timers[id].deadline = deadline <= now ? now + 1 : deadline < limit ? deadline : limit;
+			link(id);
+			scheduled++;
+		}
+
+		/**
+		 * Cancel a timer.
+		 *
+		 * \param id   the identifier of the timer
+		 * \return \c true if the timer was scheduled
+		 */
+		bool cancel(uint32_t id)
+		{
+			if (id >= timers.size() || timers[id].bucket == NONE)
+			{
+				return false;
+			}
+			unlink(id);
+			scheduled--;
+			return true;
+		}
+
+		/**
+		 * Move the wheel forward to a tick, and collect the timers expired on the way.
+		 *
+		 * \param tick      the new current tick; a tick already reached does nothing
+		 * \param expired   the vector to which the identifiers of the expired timers are appended, in the order of
+		 *                  their deadlines
+		 */
+		void advance(uint64_t tick, std::vector<uint32_t>& expired)
+		{
+			while (now < tick)
+			{
+				if (scheduled == 0)
+				{
+					now = tick;
+					return;
+				}
+				now++;
+				if ((now & (SLOTS - 1)) == 0)
+				{
+					int level = 1;
+					while (level < LEVELS - 1 && ((now >> (BITS * level)) & (SLOTS - 1)) == 0)
+					{
+						level++;
+					}
+					for (; level >= 1; level--)
+					{
+						cascade(level);
+					}
+				}
+				uint32_t bucket = static_cast<uint32_t>(now & (SLOTS - 1));
+				uint32_t id = buckets[bucket];
+				buckets[bucket] = NONE;
+				while (id != NONE)
+				{
+					uint32_t next = timers[id].next;
+					timers[id].bucket = NONE;
+					expired.push_back(id);
+					scheduled--;
+					id = next;
+				}
+			}
+		}
+
+		/**
+		 * Get the current tick.
+		 *
+		 * \return the tick the wheel was last moved to
+		 */
+		uint64_t getTick() const
+		{
+			return now;
+		}
+
+		/**
+		 * Get the number of scheduled timers.
+		 *
+		 * \return the number of timers not expired nor cancelled
+		 */
+		size_t size() const
+		{
+			return scheduled;
+		}
+	};
+
+}
+
+#endif // _MigratoryDataTimerWheel_h_included_
@@ -0,0 +1,258 @@
+#ifndef _MigratoryDataTypedListener_h_included_
+#define _MigratoryDataTypedListener_h_included_
+
+#include "MigratoryDataClient.h"
+#include "MigratoryDataListener.h"
+
+#include <string>
+
+namespace migratorydata
+{
+
+	/**
+	 * The type of a status notification, as an enumeration rather than one of the string constants of
+	 * \link MigratoryDataClient \endlink.
+	 */
+	enum class StatusCode {
+
+		/** \link MigratoryDataClient.NOTIFY_PUBLISH_OK \endlink */
+		PUBLISH_OK,
+
+		/** \link MigratoryDataClient.NOTIFY_PUBLISH_FAILED \endlink */
+		PUBLISH_FAILED,
+
+		/** \link MigratoryDataClient.NOTIFY_PUBLISH_DENIED \endlink */
+		PUBLISH_DENIED,
+
+		/** \link MigratoryDataClient.NOTIFY_MESSAGE_SIZE_LIMIT_EXCEEDED \endlink */
+		MESSAGE_SIZE_LIMIT_EXCEEDED,
+
+		/** \link MigratoryDataClient.NOTIFY_SUBSCRIBE_ALLOW \endlink */
+		SUBSCRIBE_ALLOW,
+
+		/** \link MigratoryDataClient.NOTIFY_SUBSCRIBE_DENY \endlink */
+		SUBSCRIBE_DENY,
+
+		/** \link MigratoryDataClient.NOTIFY_DATA_SYNC \endlink */
+		DATA_SYNC,
+
+		/** \link MigratoryDataClient.NOTIFY_DATA_RESYNC \endlink */
+		DATA_RESYNC,
+
+		/** \link MigratoryDataClient.NOTIFY_SERVER_UP \endlink */
+		SERVER_UP,
+
+		/** \link MigratoryDataClient.NOTIFY_SERVER_DOWN \endlink */
+		SERVER_DOWN,
+
+		/** \link MigratoryDataClient.NOTIFY_RECONNECT_RATE_EXCEEDED \endlink */
+		RECONNECT_RATE_EXCEEDED,
+
+		/** \link MigratoryDataClient.NOTIFY_CONNECT_OK \endlink */
+		CONNECT_OK,
+
+		/** \link MigratoryDataClient.NOTIFY_CONNECT_DENY \endlink */
+		CONNECT_DENY,
+
+		/** A status notification not known by this version of the helpers */
+		UNKNOWN
+
+	};
+
+	/**
+	 * A status notification, made of its type and of its detail information, which is the closure of a message, a
+	 * subject, a server or a reason depending on the type.
+	 *
+	 * The object refers to the strings given by the library and is only valid during the call of
+	 * \link MigratoryDataTypedListener.onStatusCode() \endlink; copy the strings needed afterwards.
+	 */
+	class MigratoryDataStatus
+	{
+
+	private :
+
+		StatusCode code;
+		const std::string& status;
+		const std::string& info;
+
+		static const std::string& none()
+		{
+			static const std::string empty;
+			return empty;
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataStatus object.
+		 *
+		 * \param code     the type of the status notification
+		 * \param status   the type of the status notification, as given by the library
+		 * \param info     the detail information of the status notification
+		 */
+		MigratoryDataStatus(StatusCode code, const std::string& status, const std::string& info)
+			: code(code), status(status), info(info)
+		{
+		}
+
+		/**
+		 * Get the type of the status notification.
+		 *
+		 * \return the type of the status notification
+		 */
+		StatusCode getCode() const
+		{
+			return code;
+		}
+
+		/**
+		 * Get the type of the status notification as given by the library, for instance to log it.
+		 *
+		 * \return one of the string constants of \link MigratoryDataClient \endlink
+		 */
+		const std::string& getStatus() const
+		{
+			return status;
+		}
+
+		/**
+		 * Get the detail information of the status notification.
+		 *
+		 * \return the detail information
+		 */
+		const std::string& getInfo() const
+		{
+			return info;
+		}
+
+		/**
+		 * Get the closure of the published message concerned by a publish notification.
+		 *
+		 * \return the closure for StatusCode::PUBLISH_OK, StatusCode::PUBLISH_FAILED, StatusCode::PUBLISH_DENIED and
+		 *         StatusCode::MESSAGE_SIZE_LIMIT_EXCEEDED, an empty string otherwise
+		 */
+		const std::string& getClosure() const
+		{
+			return code <= StatusCode::MESSAGE_SIZE_LIMIT_EXCEEDED ? info : none();
+		}
+
+		/**
+		 * Get the subject concerned by a subscribe or synchronization notification.
+		 *
+		 * \return the subject for StatusCode::SUBSCRIBE_ALLOW, StatusCode::SUBSCRIBE_DENY, StatusCode::DATA_SYNC and
+		 *         StatusCode::DATA_RESYNC, an empty string otherwise
+		 */
+		const std::string& getSubject() const
+		{
+			return code >= StatusCode::SUBSCRIBE_ALLOW && code <= StatusCode::DATA_RESYNC ? info : none();
+		}
+
+		/**
+		 * Get the server concerned by a connection notification.
+		 *
+		 * \return the server for StatusCode::SERVER_UP and StatusCode::SERVER_DOWN, an empty string otherwise
+		 */
+		const std::string& getServer() const
+		{
+			return code == StatusCode::SERVER_UP || code == StatusCode::SERVER_DOWN ? info : none();
+		}
+	};
+
+	/**
+	 * A listener which receives the status notifications as a \link StatusCode \endlink with a structured
+	 * \link MigratoryDataStatus \endlink, so that it can switch on their type instead of comparing strings.
+	 *
+	 * The type of a notification is found by comparing the length of the status with the lengths of the constants of
+	 * the client, which differ for most of them, and the characters only when the lengths match; the constants of the
+	 * publish notifications are tried first. No memory is allocated per notification.
+	 *
+	 * Derive from this class, implement \link onMessage() \endlink and \link onStatusCode() \endlink, and register
+	 * the listener with \link MigratoryDataClient.setListener() \endlink as usual. The typed hook has a name of its
+	 * own, so that implementing it does not hide \link onStatus() \endlink, which the library calls.
+	 */
+	class MigratoryDataTypedListener : public MigratoryDataListener
+	{
+
+	private :
+
+		struct Entry
+		{
+			const std::string* status;
+			StatusCode code;
+		};
+
+		enum : int { ENTRIES = static_cast<int>(StatusCode::UNKNOWN) };
+
+		Entry entries[ENTRIES];
+
+	public :
+
+		/**
+		 * Create a MigratoryDataTypedListener object.
+		 *
+		 * \param client   the client whose status constants are mapped; it must outlive this listener
+		 */
+		explicit MigratoryDataTypedListener(const MigratoryDataClient& client)
+			: entries{
+				{ &client.NOTIFY_PUBLISH_OK, StatusCode::PUBLISH_OK },
+				{ &client.NOTIFY_PUBLISH_FAILED, StatusCode::PUBLISH_FAILED },
+				{ &client.NOTIFY_PUBLISH_DENIED, StatusCode::PUBLISH_DENIED },
+				{ &client.NOTIFY_MESSAGE_SIZE_LIMIT_EXCEEDED, StatusCode::MESSAGE_SIZE_LIMIT_EXCEEDED },
+				{ &client.NOTIFY_SUBSCRIBE_ALLOW, StatusCode::SUBSCRIBE_ALLOW },
+				{ &client.NOTIFY_SUBSCRIBE_DENY, StatusCode::SUBSCRIBE_DENY },
+				{ &client.NOTIFY_DATA_SYNC, StatusCode::DATA_SYNC },
+				{ &client.NOTIFY_DATA_RESYNC, StatusCode::DATA_RESYNC },
+				{ &client.NOTIFY_SERVER_UP, StatusCode::SERVER_UP },
+				{ &client.NOTIFY_SERVER_DOWN, StatusCode::SERVER_DOWN },
+				{ &client.NOTIFY_RECONNECT_RATE_EXCEEDED, StatusCode::RECONNECT_RATE_EXCEEDED },
+				{ &client.NOTIFY_CONNECT_OK, StatusCode::CONNECT_OK },
+				{ &client.NOTIFY_CONNECT_DENY, StatusCode::CONNECT_DENY }
+			}
+		{
+		}
+
+		/**
+		 * Get the type of a status notification.
+		 *
+		 * \param status   the type of the status notification, as given by the library
+		 * \return the type of the status notification, or StatusCode::UNKNOWN
+		 */
+		StatusCode toStatusCode(const std::string& status) const
+		{
+			for (const Entry& entry : entries)
+			{
+				if (&status == entry.status)
+				{
+					return entry.code;
+				}
+				if (status.size() == entry.status->size() && status.compare(*entry.status) == 0)
+				{
+					return entry.code;
+				}
+			}
+			return StatusCode::UNKNOWN;
+		}
+
+		/**
+		 * Handle a status notification.
+		 *
+		 * \param status   the status notification, valid only during the call
+		 */
+		virtual void onStatusCode(const MigratoryDataStatus& status) = 0;
+
+		/**
+		 * Map the status notification to its type and call \link onStatusCode() \endlink.
+		 *
+		 * \param status The type of the status notification.
+		 * \param info The detail information of the status notification.
+		 */
+		void onStatus(const std::string& status, std::string& info)
+		{
+			MigratoryDataStatus typed(toStatusCode(status), status, info);
+			onStatusCode(typed);
+		}
+	};
+
+}
+
+#endif // _MigratoryDataTypedListener_h_included_
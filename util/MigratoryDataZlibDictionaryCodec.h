@@ -0,0 +1,264 @@
+#ifndef _MigratoryDataZlibDictionaryCodec_h_included_
+#define _MigratoryDataZlibDictionaryCodec_h_included_
+
+#include "MigratoryDataCodec.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace migratorydata
+{
+
+	/**
+	 * A codec which deflates each content with a preset dictionary shared by the publishers and the subscribers.
+	 *
+	 * Small messages with a repetitive structure, such as JSON ticks with the same keys, barely shrink when deflated
+	 * one by one, because each message starts with an empty history. With a preset dictionary made of the strings
+	 * common to such messages, deflate refers to the dictionary from the first byte. A dictionary is built from
+	 * captured contents with \link train() \endlink, and must be the same on both sides.
+	 *
+	 * An encoded content is the size of the decoded content as a variable-length integer, followed by the raw
+	 * deflate stream. The encoding and the decoding reuse one deflate and one inflate stream, so each of them is
+	 * serialized; use one codec per thread to encode or decode in parallel.
+	 *
+	 * This codec requires zlib.
+	 */
+	class MigratoryDataZlibDictionaryCodec : public MigratoryDataCodec
+	{
+
+	private :
+
+		// A bound on the decoded size which protects the decoder from corrupted contents.
+		enum : size_t { MAX_CONTENT_SIZE = 64 * 1024 * 1024 };
+
+		unsigned char id;
+		std::string dictionary;
+		std::mutex deflateMutex;
+		std::mutex inflateMutex;
+		z_stream deflater;
+		z_stream inflater;
+
+		static void putSize(std::string& out, size_t value)
+		{
+			while (value >= 0x80)
+			{
+				out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+				value >>= 7;
+			}
+			out.push_back(static_cast<char>(value));
+		}
+
+		static bool getSize(const unsigned char*& p, const unsigned char* end, size_t& value)
+		{
+			value = 0;
+			for (int shift = 0; p < end && shift < 35; shift += 7)
+			{
+				unsigned char b = *p++;
+				value |= static_cast<size_t>(b & 0x7F) << shift;
+				if ((b & 0x80) == 0)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+
+	public :
+
+		/**
+		 * Create a MigratoryDataZlibDictionaryCodec object.
+		 *
+		 * \param id           the identifier of the codec, from \c 1 to \c 255
+		 * \param dictionary   the preset dictionary, as returned by \link train() \endlink; only its last 32 KB are
+		 *                     used
+		 * \param level        the compression level, from \c 1 (fastest) to \c 9 (smallest)
+		 */
+		MigratoryDataZlibDictionaryCodec(unsigned char id, const std::string& dictionary, int level = 6)
+			: id(id), dictionary(dictionary.size() > 32768 ? dictionary.substr(dictionary.size() - 32768) : dictionary),
+			deflater(), inflater()
+		{
+			if (deflateInit2(&deflater, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			{
+				throw std::runtime_error("cannot initialize the deflate stream");
+			}
+			if (inflateInit2(&inflater, -15) != Z_OK)
+			{
+				deflateEnd(&deflater);
+				throw std::runtime_error("cannot initialize the inflate stream");
+			}
+		}
+
+		MigratoryDataZlibDictionaryCodec(const MigratoryDataZlibDictionaryCodec&) = delete;
+		MigratoryDataZlibDictionaryCodec& operator=(const MigratoryDataZlibDictionaryCodec&) = delete;
+
+		unsigned char getId() const
+		{
+			return id;
+		}
+
+		bool encode(const std::string& content, std::string& encoded)
+		{
+			size_t start = encoded.size();
+			putSize(encoded, content.size());
+			size_t header = encoded.size();
+
+			std::lock_guard<std::mutex> lock(deflateMutex);
+			deflateReset(&deflater);
+			if (!dictionary.empty())
+			{
+				deflateSetDictionary(&deflater, reinterpret_cast<const Bytef*>(dictionary.data()), static_cast<uInt>(dictionary.size()));
+			}
+			encoded.resize(header + deflateBound(&deflater, static_cast<uLong>(content.size())));
+			deflater.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(content.data()));
+			deflater.avail_in = static_cast<uInt>(content.size());
+			deflater.next_out = reinterpret_cast<Bytef*>(&encoded[header]);
+			deflater.avail_out = static_cast<uInt>(encoded.size() - header);
+			if (deflate(&deflater, Z_FINISH) != Z_STREAM_END)
+			{
+				encoded.resize(start);
+				return false;
+			}
+			encoded.resize(encoded.size() - deflater.avail_out);
+			return true;
+		}
+
+		bool decode(const char* data, size_t size, std::string& content)
+		{
+			const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+			const unsigned char* end = p + size;
+			size_t decodedSize;
+			if (!getSize(p, end, decodedSize) || decodedSize > MAX_CONTENT_SIZE)
+			{
+				return false;
+			}
+			content.resize(decodedSize);
+
+			std::lock_guard<std::mutex> lock(inflateMutex);
+			inflateReset(&inflater);
+			if (!dictionary.empty())
+			{
+				inflateSetDictionary(&inflater, reinterpret_cast<const Bytef*>(dictionary.data()), static_cast<uInt>(dictionary.size()));
+			}
+			inflater.next_in = const_cast<Bytef*>(p);
+			inflater.avail_in = static_cast<uInt>(end - p);
+			inflater.next_out = reinterpret_cast<Bytef*>(&content[0]);
+			inflater.avail_out = static_cast<uInt>(decodedSize);
+			return inflate(&inflater, Z_FINISH) == Z_STREAM_END && inflater.avail_out == 0;
+		}
+
+		/**
+		 * Build a dictionary from sample contents, such as contents captured from the subjects using the codec.
+		 *
+		 * The samples are cut into segments of \c segmentSize bytes, and the segments made of the byte sequences
+		 * shared by the largest number of samples are selected until the dictionary is full. As deflate encodes
+		 * nearer references with fewer bits, the most useful segments are placed at the end of the dictionary.
+		 *
+		 * \param samples       sample contents, typically a few thousand
+		 * \param size          the maximum size of the dictionary in bytes; at most 32 KB are useful
+		 * \param segmentSize   the size of the segments making up the dictionary
+		 * \return the dictionary
+		 */
+		static std::string train(const std::vector<std::string>& samples, size_t size, size_t segmentSize = 32)
+		{
+			const size_t gramSize = 6;
+			if (segmentSize < gramSize)
+			{
+				segmentSize = gramSize;
+			}
+
+			// number of samples containing each sequence of gramSize bytes
+			std::unordered_map<std::string, uint32_t> frequency;
+			std::vector<std::pair<size_t, size_t>> positions;
+			for (size_t s = 0; s < samples.size(); s++)
+			{
+				const std::string& sample = samples[s];
+				std::unordered_set<std::string> seen;
+				for (size_t i = 0; i + gramSize <= sample.size(); i++)
+				{
+					std::string gram = sample.substr(i, gramSize);
+					if (seen.insert(gram).second)
+					{
+						frequency[gram]++;
+					}
+				}
+				for (size_t i = 0; i + segmentSize <= sample.size(); i++)
+				{
+					positions.push_back(std::make_pair(s, i));
+				}
+			}
+			if (positions.empty())
+			{
+				return std::string();
+			}
+
+			// pick the best segment of each epoch, then forget the sequences it covers
+			size_t epochs = std::max<size_t>(1, std::min(positions.size(), size / segmentSize));
+			size_t epochSize = positions.size() / epochs;
+			std::vector<std::pair<uint64_t, std::string>> selected;
+			for (size_t e = 0; e < epochs; e++)
+			{
+				uint64_t bestScore = 0;
+				size_t best = 0;
+				for (size_t k = e * epochSize; k < (e + 1) * epochSize; k++)
+				{
+					const std::string& sample = samples[positions[k].first];
+					uint64_t score = 0;
+					for (size_t i = positions[k].second; i + gramSize <= positions[k].second + segmentSize; i++)
+					{
+						auto it = frequency.find(sample.substr(i, gramSize));
+						if (it != frequency.end() && it->second > 1)
+						{
+							score += it->second;
+						}
+					}
+					if (score > bestScore)
+					{
+						bestScore = score;
+						best = k;
+					}
+				}
+				if (bestScore == 0)
+				{
+					continue;
+				}
+				std::string segment = samples[positions[best].first].substr(positions[best].second, segmentSize);
+				for (size_t i = 0; i + gramSize <= segment.size(); i++)
+				{
+					frequency[segment.substr(i, gramSize)] = 0;
+				}
+				selected.push_back(std::make_pair(bestScore, segment));
+			}
+
+			std::stable_sort(selected.begin(), selected.end(),
+				[](const std::pair<uint64_t, std::string>& a, const std::pair<uint64_t, std::string>& b) { return a.first < b.first; });
+			std::string result;
+			for (auto& segment : selected)
+			{
+				result += segment.second;
+			}
+			return result.size() > size ? result.substr(result.size() - size) : result;
+		}
+
+		/**
+		 * \brief Destructor.
+		 */
+		virtual ~MigratoryDataZlibDictionaryCodec()
+		{
+			deflateEnd(&deflater);
+			inflateEnd(&inflater);
+		}
+	};
+
+}
+
+#endif // _MigratoryDataZlibDictionaryCodec_h_included_